@@ -0,0 +1,91 @@
+// Counts heap allocations on the per-event primary path: flux sampling with the cached particle definition
+// and, with a batch size, the PrimaryBatch refill. Run from the build directory, like GammaCube:
+// AllocCheck [flux type] [primaries] [batch]
+// Exit status 1 if anything is allocated once the first primaries have resolved their lookups.
+
+#include "Flux/Flux.hh"
+#include "PrimaryBatch.hh"
+#include "Sizes.hh"
+
+#include <G4BaryonConstructor.hh>
+#include <G4BosonConstructor.hh>
+#include <G4IonConstructor.hh>
+#include <G4LeptonConstructor.hh>
+#include <G4MesonConstructor.hh>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+    bool counting = false;
+    long allocations = 0;
+}
+
+void *operator new(const std::size_t size) {
+    if (counting) ++allocations;
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+
+int main(int argc, char **argv) {
+    const G4String type = argc > 1 ? argv[1] : "Galactic";
+    const long primaries = argc > 2 ? std::atol(argv[2]) : 1000000;
+    const long batchSize = argc > 3 ? std::atol(argv[3]) : 0;
+
+    G4BosonConstructor::ConstructParticle();
+    G4LeptonConstructor::ConstructParticle();
+    G4MesonConstructor::ConstructParticle();
+    G4BaryonConstructor::ConstructParticle();
+    G4IonConstructor::ConstructParticle();
+    G4ParticleTable::GetParticleTable()->SetReadiness();
+
+    const std::unique_ptr<Flux> flux(Flux::Create(type, 0.0));
+    if (!flux) {
+        std::printf("Unknown flux type %s\n", type.c_str());
+        return 1;
+    }
+    // Same sphere as PrimaryGeneratorAction
+    std::unique_ptr<PrimaryBatch> batch;
+    if (batchSize > 0) {
+        const G4ThreeVector halfSize(0, Sizes::modelRadius, Sizes::modelHeight);
+        const G4double radius = halfSize.mag() + 5 * mm;
+        batch = std::make_unique<PrimaryBatch>(batchSize, FluxDir::Isotropic,
+                                               G4ThreeVector(0, 0, -Sizes::modelHeight / 2.0), radius, halfSize);
+    }
+
+    G4ThreeVector pos, dir;
+    ParticleInfo info{};
+    G4double sum = 0.0;
+    const auto draw = [&] {
+        if (batch) {
+            if (batch->Empty()) {
+                batch->Refill();
+                for (auto &b: batch->Info()) b = flux->GenerateParticle();
+            }
+            batch->Pop(pos, dir, info);
+        } else {
+            info = flux->GenerateParticle();
+        }
+        sum += info.energy * info.weight + dir.z();
+    };
+
+    // The first primaries look the particle definitions up
+    for (long k = 0; k < 2 * batchSize + 1000; ++k) draw();
+
+    counting = true;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (long k = 0; k < primaries; ++k) draw();
+    const auto t1 = std::chrono::steady_clock::now();
+    counting = false;
+
+    const G4double ns = std::chrono::duration<G4double, std::nano>(t1 - t0).count() / static_cast<G4double>(primaries);
+    std::printf("%-9s batch %-6ld %ld primaries  %.1f ns/primary  %ld allocations  (checksum %g)\n",
+                type.c_str(), batchSize, primaries, ns, allocations, sum);
+    return allocations == 0 ? 0 : 1;
+}
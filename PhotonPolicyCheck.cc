@@ -0,0 +1,127 @@
+// Compares a --photon-policy run with a full-tracking run of the same configuration and number of events:
+// the npe distribution of one subdetector, its mean shift and the npe_lost the policy run reported for it.
+// Both runs with the default --format root and without --async-output:
+// PhotonPolicyCheck <full.root> <policy.root> [crystal|veto|bottom_veto]
+// Exit status 1 if the mean npe drops by more than the reported npe_lost (3 sigma), which the
+// estimate should bound from above, or if a file has no sipm_event tree.
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+namespace {
+    struct Sample {
+        std::vector<double> npe;
+        std::vector<double> lost;
+    };
+
+    double Mean(const std::vector<double> &v) {
+        double s = 0.0;
+        for (const double x: v) s += x;
+        return v.empty() ? 0.0 : s / static_cast<double>(v.size());
+    }
+
+    // Standard error of the mean
+    double Error(const std::vector<double> &v) {
+        if (v.size() < 2) return 0.0;
+        const double m = Mean(v);
+        double s = 0.0;
+        for (const double x: v) s += (x - m) * (x - m);
+        return std::sqrt(s / static_cast<double>(v.size() - 1) / static_cast<double>(v.size()));
+    }
+
+    bool Read(const char *path, const std::string &subdet, Sample &out) {
+        const std::unique_ptr<TFile> file(TFile::Open(path, "READ"));
+        TTree *tree = nullptr;
+        if (file && !file->IsZombie()) file->GetObject("sipm_event", tree);
+        if (!tree) {
+            std::printf("%s: no sipm_event tree\n", path);
+            return false;
+        }
+
+        double npe = 0.0, lost = 0.0;
+        tree->SetBranchStatus("*", false);
+        tree->SetBranchStatus(("npe_" + subdet).c_str(), true);
+        tree->SetBranchStatus(("npe_lost_" + subdet).c_str(), true);
+        tree->SetBranchAddress(("npe_" + subdet).c_str(), &npe);
+        tree->SetBranchAddress(("npe_lost_" + subdet).c_str(), &lost);
+
+        const Long64_t n = tree->GetEntries();
+        out.npe.reserve(n);
+        out.lost.reserve(n);
+        for (Long64_t i = 0; i < n; ++i) {
+            tree->GetEntry(i);
+            out.npe.push_back(npe);
+            out.lost.push_back(lost);
+        }
+        tree->ResetBranchAddresses();
+        return !out.npe.empty();
+    }
+
+    // Two samples of different size on common bins; the upper tail as in SpectrumCheck
+    void ChiSquare(const char *name, const std::vector<double> &a, const std::vector<double> &b) {
+        constexpr size_t bins = 50;
+        const double hi = std::max(*std::max_element(a.begin(), a.end()), *std::max_element(b.begin(), b.end()));
+        const double width = hi > 0.0 ? hi / bins : 1.0;
+        std::vector<double> ha(bins, 0.0), hb(bins, 0.0);
+        for (const double x: a) ha[std::min(static_cast<size_t>(std::max(x, 0.0) / width), bins - 1)] += 1.0;
+        for (const double x: b) hb[std::min(static_cast<size_t>(std::max(x, 0.0) / width), bins - 1)] += 1.0;
+
+        const double na = static_cast<double>(a.size()), nb = static_cast<double>(b.size());
+        const double ka = std::sqrt(nb / na), kb = std::sqrt(na / nb);
+        double chi2 = 0.0;
+        int ndf = -1;
+        for (size_t i = 0; i < bins; ++i) {
+            if (ha[i] + hb[i] <= 0.0) continue;
+            chi2 += (ka * ha[i] - kb * hb[i]) * (ka * ha[i] - kb * hb[i]) / (ha[i] + hb[i]);
+            ++ndf;
+        }
+        double p = 1.0;
+        if (ndf > 0) {
+            const double k = ndf;
+            const double z = (std::cbrt(chi2 / k) - (1.0 - 2.0 / (9.0 * k))) / std::sqrt(2.0 / (9.0 * k));
+            p = 0.5 * std::erfc(z / std::sqrt(2.0));
+        }
+        std::printf("%-32s chi2/ndf %8.1f/%-3d p %.3g\n", name, chi2, ndf, p);
+    }
+}
+
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::printf("PhotonPolicyCheck <full.root> <policy.root> [crystal|veto|bottom_veto]\n");
+        return 1;
+    }
+    const std::string subdet = argc > 3 ? argv[3] : "crystal";
+
+    Sample full, policy;
+    if (!Read(argv[1], subdet, full) || !Read(argv[2], subdet, policy)) return 1;
+
+    const double mFull = Mean(full.npe), eFull = Error(full.npe);
+    const double mPolicy = Mean(policy.npe), ePolicy = Error(policy.npe);
+    const double mLost = Mean(policy.lost), eLost = Error(policy.lost);
+    const double shift = mFull - mPolicy;
+    const double eShift = std::sqrt(eFull * eFull + ePolicy * ePolicy);
+
+    std::printf("npe_%s  full: %zu events, mean %.4g +- %.2g   policy: %zu events, mean %.4g +- %.2g\n",
+                subdet.c_str(), full.npe.size(), mFull, eFull, policy.npe.size(), mPolicy, ePolicy);
+    std::printf("mean shift %.4g +- %.2g   reported npe_lost %.4g +- %.2g   shift / npe_lost %.3g\n",
+                shift, eShift, mLost, eLost, mLost > 0.0 ? shift / mLost : 0.0);
+
+    // The policy run with its estimate added back, against full tracking
+    std::vector<double> corrected(policy.npe.size());
+    for (size_t i = 0; i < corrected.size(); ++i) corrected[i] = policy.npe[i] + policy.lost[i];
+    ChiSquare(("npe_" + subdet + " policy vs full").c_str(), policy.npe, full.npe);
+    ChiSquare(("npe_" + subdet + " + npe_lost vs full").c_str(), corrected, full.npe);
+
+    const bool pass = shift <= mLost + 3.0 * std::sqrt(eShift * eShift + eLost * eLost);
+    std::printf("%s\n", pass ? "ok: npe_lost bounds the shift" : "FAIL: the shift exceeds npe_lost");
+    return pass ? 0 : 1;
+}
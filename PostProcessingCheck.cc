@@ -0,0 +1,113 @@
+// Pile-up in the schema 1 CSVs: the primary tree holds the leading primary of an event first and its
+// background primaries after it, and trig_edep.csv and edep.csv must carry the leading energy.
+// Writes a small ROOT file under PostProcessingCheck/ in the working directory, runs SaveTrigEdepCsv
+// and SaveEdepCsv on it and reads the CSVs back: PostProcessingCheck
+// Exit status 1 if any event is labelled with another energy.
+
+#include "PostProcessing.hh"
+
+#include <map>
+
+namespace fs = std::filesystem;
+
+
+namespace {
+    struct Primary {
+        Int_t eventID;
+        double E_MeV;
+        double t0_ns;
+    };
+
+    struct Deposit {
+        Int_t eventID;
+        const char *det_name;
+        double edep_MeV;
+    };
+
+    // Event 0 and 2 carry pile-up, event 2 does not trigger
+    const Primary primaries[] = {{0, 1.0, 0.0}, {0, 5.0, 310.0}, {1, 2.0, 0.0},
+                                 {2, 3.0, 0.0}, {2, 0.5, 120.0}, {2, 7.0, 840.0}};
+    const Deposit deposits[] = {{0, "Crystal", 0.8}, {0, "Crystal", 4.1}, {1, "Crystal", 1.5}, {2, "Veto", 0.2}};
+
+    void WriteFile(const std::string &path) {
+        TFile file(path.c_str(), "RECREATE");
+
+        Int_t eventID = 0;
+        double E_MeV = 0.0, t0_ns = 0.0;
+        TTree primary("primary", "per-primary particles");
+        primary.Branch("eventID", &eventID, "eventID/I");
+        primary.Branch("E_MeV", &E_MeV, "E_MeV/D");
+        primary.Branch("t0_ns", &t0_ns, "t0_ns/D");
+        for (const Primary &p: primaries) {
+            eventID = p.eventID;
+            E_MeV = p.E_MeV;
+            t0_ns = p.t0_ns;
+            primary.Fill();
+        }
+
+        char det_name[64] = {};
+        double edep_MeV = 0.0;
+        TTree edep("edep", "energy deposition per sensitive channel");
+        edep.Branch("eventID", &eventID, "eventID/I");
+        edep.Branch("det_name", det_name, "det_name/C");
+        edep.Branch("edep_MeV", &edep_MeV, "edep_MeV/D");
+        for (const Deposit &d: deposits) {
+            eventID = d.eventID;
+            std::snprintf(det_name, sizeof(det_name), "%s", d.det_name);
+            edep_MeV = d.edep_MeV;
+            edep.Fill();
+        }
+
+        file.Write();
+        file.Close();
+    }
+
+    // eventID and the E0 column of every row
+    bool Check(const std::string &path, const std::map<int, double> &expected) {
+        std::ifstream in(path);
+        std::string line;
+        if (!in || !std::getline(in, line)) {
+            std::printf("%s: missing\n", path.c_str());
+            return false;
+        }
+        size_t rows = 0;
+        bool pass = true;
+        while (std::getline(in, line)) {
+            int eventID = 0;
+            double e0 = 0.0;
+            if (std::sscanf(line.c_str(), "%d,%lf", &eventID, &e0) != 2) continue;
+            ++rows;
+            const auto it = expected.find(eventID);
+            if (it == expected.end() || it->second != e0) {
+                std::printf("%s: event %d labelled %g MeV\n", path.c_str(), eventID, e0);
+                pass = false;
+            }
+        }
+        std::printf("%-50s %zu rows  %s\n", path.c_str(), rows, pass && rows ? "ok" : "FAIL");
+        return pass && rows > 0;
+    }
+}
+
+
+int main() {
+    fs::create_directories("PostProcessingCheck");
+    Configuration::outputFile = "PostProcessingCheck/pileup.root";
+    Configuration::outputFormat = "root";
+    Configuration::asyncOutput = false;
+    Configuration::edepSchema = 1;
+    WriteFile(Configuration::outputFile);
+
+    const std::map<int, double> expected = {{0, 1.0}, {1, 2.0}, {2, 3.0}};
+    try {
+        PostProcessing postProcessing("pileup", 0.0, 10.0, "gamma");
+        postProcessing.SaveTrigEdepCsv();
+        postProcessing.SaveEdepCsv();
+    } catch (const std::exception &e) {
+        std::printf("%s\n", e.what());
+        return 1;
+    }
+    const fs::path dir = fs::path("PostProcessingCheck") / "post_processing" / "pileup" / "Histograms";
+    bool pass = Check((dir / "trig_edep.csv").string(), expected);
+    pass = Check((dir / "edep.csv").string(), expected) && pass;
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Compares the alias-table sampler of the tabulated fluxes with the CDF inversion it replaced.
+// Run from the build directory, like GammaCube: SpectrumCheck [draws] [seed]
+// Exit status 1 if any flux fails the two-sample chi-square test at p < 1e-3.
+
+#include "Flux/Flux.hh"
+
+#include <CLHEP/Random/Random.h>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+
+namespace {
+    // Inversions as they were before the alias table, on the same grid and CDF
+    G4double InvertLogLinear(const Spectrum &s) {
+        const G4double *cdf = s.CDF();
+        const G4double *logE = s.LogE();
+        const size_t n = s.Size();
+        const G4double u = G4UniformRand();
+        const G4double *it = std::upper_bound(cdf, cdf + n, u);
+        if (it == cdf) return std::exp(logE[0]);
+        if (it == cdf + n) return std::exp(logE[n - 1]);
+        const size_t j = static_cast<size_t>(it - cdf);
+        const G4double t = (u - cdf[j - 1]) / std::max(cdf[j] - cdf[j - 1], 1e-12);
+        return std::exp(logE[j - 1] + t * (logE[j] - logE[j - 1]));
+    }
+
+    G4double InvertLinear(const Spectrum &s) {
+        const G4double *cdf = s.CDF();
+        const G4double *logE = s.LogE();
+        const size_t n = s.Size();
+        const G4double u = G4UniformRand();
+        const G4double *it = std::lower_bound(cdf, cdf + n, u);
+        if (it == cdf) return std::exp(logE[0]);
+        if (it == cdf + n) return std::exp(logE[n - 1]);
+        const size_t j = static_cast<size_t>(it - cdf);
+        const G4double E1 = std::exp(logE[j - 1]);
+        const G4double E2 = std::exp(logE[j]);
+        const G4double t = (u - cdf[j - 1]) / (cdf[j] - cdf[j - 1]);
+        return E1 + t * (E2 - E1);
+    }
+
+    // Upper tail of chi-square (Wilson-Hilferty), enough to tell 1e-3 from a pass
+    G4double ChiSquareP(const G4double chi2, const G4int ndf) {
+        if (ndf <= 0) return 1.0;
+        const G4double k = ndf;
+        const G4double z = (std::cbrt(chi2 / k) - (1.0 - 2.0 / (9.0 * k))) / std::sqrt(2.0 / (9.0 * k));
+        return 0.5 * std::erfc(z / std::sqrt(2.0));
+    }
+
+    struct Histogram {
+        std::vector<G4double> a, b;
+
+        explicit Histogram(const size_t bins) : a(bins, 0.0), b(bins, 0.0) {}
+
+        // Two samples of equal size
+        [[nodiscard]] G4double ChiSquare(G4int &ndf) const {
+            G4double chi2 = 0.0;
+            ndf = -1;
+            for (size_t i = 0; i < a.size(); ++i) {
+                if (a[i] + b[i] <= 0.0) continue;
+                chi2 += (a[i] - b[i]) * (a[i] - b[i]) / (a[i] + b[i]);
+                ++ndf;
+            }
+            return chi2;
+        }
+    };
+
+    // ln E over the grid, and the position inside the grid bin, where linear and log-linear differ
+    G4bool Compare(const char *name, const Spectrum &s, const std::function<G4double(const Spectrum &)> &old,
+                   const long draws) {
+        const G4double *logE = s.LogE();
+        const size_t n = s.Size();
+        const G4double lo = logE[0];
+        const G4double span = logE[n - 1] - lo;
+
+        constexpr size_t spectrumBins = 200;
+        constexpr size_t shapeBins = 20;
+        Histogram spectrum(spectrumBins), shape(shapeBins);
+
+        const auto fill = [&](const G4double E, std::vector<G4double> &hs, std::vector<G4double> &ht) {
+            const G4double lnE = std::log(E);
+            const G4double x = (lnE - lo) / span;
+            hs[std::min(static_cast<size_t>(std::max(x, 0.0) * spectrumBins), spectrumBins - 1)] += 1.0;
+            const size_t j = static_cast<size_t>(std::upper_bound(logE, logE + n, lnE) - logE);
+            const size_t i = std::min(j > 0 ? j - 1 : 0, n - 2);
+            const G4double t = (lnE - logE[i]) / (logE[i + 1] - logE[i]);
+            ht[std::min(static_cast<size_t>(std::max(t, 0.0) * shapeBins), shapeBins - 1)] += 1.0;
+        };
+
+        for (long k = 0; k < draws; ++k) fill(s.Sample(), spectrum.a, shape.a);
+        for (long k = 0; k < draws; ++k) fill(old(s), spectrum.b, shape.b);
+
+        G4int ndfS, ndfT;
+        const G4double chiS = spectrum.ChiSquare(ndfS);
+        const G4double chiT = shape.ChiSquare(ndfT);
+        const G4double pS = ChiSquareP(chiS, ndfS);
+        const G4double pT = ChiSquareP(chiT, ndfT);
+        const G4bool pass = pS >= 1e-3 && pT >= 1e-3;
+        std::printf("%-9s grid %5zu  ln E: chi2/ndf %8.1f/%-3d p %.3g   in-bin: chi2/ndf %8.1f/%-3d p %.3g   %s\n",
+                    name, n, chiS, ndfS, pS, chiT, ndfT, pT, pass ? "ok" : "FAIL");
+        return pass;
+    }
+}
+
+
+int main(int argc, char **argv) {
+    const long draws = argc > 1 ? std::atol(argv[1]) : 10000000;
+    const long seed = argc > 2 ? std::atol(argv[2]) : 12345;
+    CLHEP::HepRandom::setTheSeed(seed);
+
+    // Table and SEP were inverted log-linearly, COMP and Galactic linearly in E
+    const struct {
+        const char *type;
+        G4double (*old)(const Spectrum &);
+    } cases[] = {{"Table", InvertLogLinear}, {"SEP", InvertLogLinear}, {"COMP", InvertLinear}, {"Galactic", InvertLinear}};
+
+    G4bool pass = true;
+    for (const auto &c: cases) {
+        std::unique_ptr<Flux> flux(Flux::Create(c.type, 0.0));
+        const std::shared_ptr<const Spectrum> s = flux ? flux->GetSpectrum() : nullptr;
+        if (!s || s->Empty()) {
+            std::printf("%-9s no tabulated spectrum\n", c.type);
+            pass = false;
+            continue;
+        }
+        pass = Compare(c.type, *s, c.old, draws) && pass;
+    }
+    return pass ? 0 : 1;
+}
@@ -7,6 +7,7 @@
 #include "PrimaryGeneratorAction.hh"
 #include "EventAction.hh"
 #include "SteppingAction.hh"
+#include "StackingAction.hh"
 #include "Configuration.hh"
 #include "Geometry.hh"
 
@@ -22,6 +23,9 @@ private:
     G4double EminMeV;
     G4double EmaxMeV;
     G4double area;
+
+    // Built once in BuildForMaster and shared read-only by all workers, one per component of a composite
+    mutable SharedSpectra spectra;
 };
 
 #endif //ACTIONINITIALIZATION_HH
@@ -5,11 +5,19 @@
 #include <G4AccumulableManager.hh>
 #include <G4Accumulable.hh>
 #include <G4UnitsTable.hh>
+#include <G4RunManager.hh>
+#include <G4Threading.hh>
 #include <CLHEP/Units/SystemOfUnits.h>
 #include <globals.hh>
 #include <Sizes.hh>
 #include <Configuration.hh>
 
+#include "InteractionBuffer.hh"
+#include "AsyncWriter.hh"
+#include "GcevStore.hh"
+
+#include <memory>
+
 class AnalysisManager {
 public:
     G4String fileName = "GammaDetector";
@@ -25,24 +33,26 @@ public:
 
     void FillPrimaryRow(G4int eventID, const G4String& primaryName,
                         G4double E_MeV, const G4ThreeVector& dir,
-                        const G4ThreeVector& pos_mm);
+                        const G4ThreeVector& pos_mm, G4double weight = 1.0,
+                        G4double t0_ns = 0.0, G4int species = 0);
 
-    void FillInteractionRow(G4int eventID,
-                            G4int trackID, G4int parentID,
-                            const G4String& process,
-                            const G4String& volumeName,
-                            const G4ThreeVector& x_mm,
-                            G4int secIndex, const G4String& secName,
-                            G4double secE_MeV, const G4ThreeVector& secDir);
+    void FillInteractionRows(G4int eventID, const InteractionBuffer& buf);
+    void FillDictionaryRow(const G4String& kind, G4int code, const G4String& name);
 
-    void FillEdepRow(G4int eventID, const G4String& det_name, G4double edep_MeV);
+    void FillEdepRow(G4int eventID, const G4String& det_name, G4double edep_MeV, G4double tmin_ns);
+    // --edep-schema 2; trigger bits: 1 crystal edep, 2 veto edep, 4 crystal npe, 8 veto npe
+    void FillEventSummaryRow(G4int eventID, G4double E0_MeV, G4int species,
+                             G4double edepC, G4double edepV, G4double edepB, G4int trigger,
+                             G4double npeC, G4double npeV, G4double npeB);
 
-    void FillSiPMEventRow(int eventID, int npeC, int npeV, int npeB);
-    void FillSiPMChannelRow(int eventID, const G4String& subdet, int ch, int npe);
+    void FillSiPMEventRow(int eventID, double npeC, double npeV, double npeB,
+                          double varC, double varV, double varB,
+                          double lostC, double lostV, double lostB, double killed, int saturated);
+    void FillSiPMChannelRow(int eventID, const G4String& subdet, int ch, double npe, double var, double tFirst_ns);
 
     void FillPhotonCountRow(G4int eventID,
-                            G4int npeCrystal, G4int npeVeto,
-                            G4int npeBottomVeto);
+                            G4double npeCrystal, G4double npeVeto,
+                            G4double npeBottomVeto);
 
     void FillPhotonRow(G4int eventID, G4int photonID, const G4String& det_name, G4int det_ch,
                        G4double energy_eV, G4double x_mm, G4double y_mm, G4double z_mm);
@@ -61,9 +71,11 @@ private:
     G4int eventNT{-1};
     G4int primaryNT{-1};
     G4int interactionsNT{-1};
+    G4int dictionaryNT{-1};
     G4int photonsCountNT{-1};
     G4int photonsNT{-1};
     G4int edepNT{-1};
+    G4int eventSummaryNT{-1};
 
     G4int SiPMEventNT{-1};
     G4int SiPMChannelNT{-1};
@@ -82,7 +94,31 @@ private:
     G4double xMin{0};
     G4double xMax{1000 * MeV};
 
+    G4AnalysisManager* g4{nullptr};  // this thread's instance
+    G4int booking{-1};               // NtupleSchema table whose columns are being created
+    NtupleRecord row;                // --async-output, --format gcev: the row being filled
+    std::unique_ptr<GcevWriter> gcev;
+
+    // Ntuples go to G4AnalysisManager, to the AsyncWriter with --async-output, or to GcevWriter with --format gcev;
+    // resolved once, since every Fill checks it
+    const G4bool gcevOutput{Configuration::outputFormat == "gcev"};
+    const G4bool ownNtuples{Configuration::asyncOutput || gcevOutput};
+
     void Book();
+
+    G4int CreateNtuple(const G4String& name, const G4String& title);
+    void CreateColumn(char type, const G4String& name);
+    void CreateIColumn(const G4String& name) { CreateColumn('I', name); }
+    void CreateFColumn(const G4String& name) { CreateColumn('F', name); }
+    void CreateDColumn(const G4String& name) { CreateColumn('D', name); }
+    void CreateSColumn(const G4String& name) { CreateColumn('S', name); }
+    void FinishNtuple(G4int nt);
+
+    void FillI(G4int nt, G4int col, G4int v);
+    void FillF(G4int nt, G4int col, G4float v);
+    void FillD(G4int nt, G4int col, G4double v);
+    void FillS(G4int nt, G4int col, const G4String& v);
+    void AddRow(G4int nt);
 };
 
 
@@ -0,0 +1,57 @@
+#ifndef ASYNCWRITER_HH
+#define ASYNCWRITER_HH
+
+#include "NtupleSchema.hh"
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+// --async-output: the event-level ntuple rows leave the worker threads as fixed-size records. Every
+// thread pushes into its own single-producer/single-consumer ring and one writer thread drains the
+// rings into TTrees of a second ROOT file (PathFor), so there is nothing to merge at the end of the run.
+// The rings share a fixed memory budget; a producer whose ring is full waits for the writer.
+class AsyncWriter {
+public:
+    using Record = NtupleRecord;
+
+    static AsyncWriter &Instance();
+
+    // Master only: before the workers start and after they have all finished
+    void Start(const G4String &path, G4int nThreads, size_t budgetBytes);
+    void Stop();
+
+    // Blocks while the calling thread's ring is full
+    void Push(const Record &record);
+
+    static G4String PathFor(const G4String &outputFile);
+
+private:
+    // Indices only ever grow; the producer owns tail, the writer owns head
+    class Ring {
+    public:
+        explicit Ring(size_t capacity) : slots(capacity), mask(capacity - 1) {}
+
+        bool TryPush(const Record &record);
+        bool TryPop(Record &record);
+
+    private:
+        std::vector<Record> slots;
+        size_t mask;
+        alignas(64) std::atomic<size_t> head{0};
+        alignas(64) std::atomic<size_t> tail{0};
+    };
+
+    std::vector<std::unique_ptr<Ring>> rings;  // slot 0 master, 1 + thread id for workers
+    std::thread writer;
+    std::atomic<G4bool> stopping{false};
+    G4bool running = false;
+
+    void Drain(const G4String &path);
+};
+
+#endif //ASYNCWRITER_HH
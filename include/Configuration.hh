@@ -4,6 +4,7 @@
 #include <G4String.hh>
 #include <G4Types.hh>
 #include <G4SystemOfUnits.hh>
+#include <vector>
 
 
 namespace Configuration
@@ -12,15 +13,34 @@ namespace Configuration
 
     inline G4String fluxType{"Uniform"};
     inline G4String fluxDirection{"isotropic"};
+    inline std::vector<G4String> fluxComponents{};  // species of the Composite flux, in config order
+    inline G4String energyBias{"none"};
+    inline G4bool rayCulling{false};
+    inline G4int primaryBatch{0};
+    inline G4double pileupRate{0 * hertz};
+    inline G4double pileupWindow{0 * ns};
 
     inline G4double eCrystalThreshold{0 * MeV};
     inline G4double eVetoThreshold{0 * MeV};
+    inline G4bool earlyAbort{false};  // stop an event once its veto has fired
 
     inline G4bool useOptics{false};
-    inline G4int yieldScale{1};
+    inline G4double photonThinning{1};  // 1 in N optical photons is tracked, with weight N
     inline G4int oCrystalThreshold{0};
     inline G4int oVetoThreshold{0};
     inline G4int oBottomVetoThreshold{0};
+    // Detected npe past which a subdetector's remaining photons are killed, 0 = no cap
+    inline G4double npeCapCrystal{0};
+    inline G4double npeCapVeto{0};
+    inline G4double npeCapBottomVeto{0};
+
+    inline G4bool lutCalibrate{false};  // shoot photons from a voxel grid and write the light-collection table
+    inline G4bool lightLUT{false};      // draw npe from the light-collection table instead of tracking photons
+    inline G4bool crystalFastOptics{false};  // contained electrons in the crystal skip photon tracking
+    inline G4String lutFile{""};        // empty = LightLUT::DefaultPath()
+    inline G4int lutVoxels{10};         // grid cells per axis of every scintillator
+    inline G4int lutPhotons{1000};      // photons per calibration event
+    inline G4String photonPolicy{""};   // PhotonPolicy spec file, empty = track every photon to the end
 
     inline G4String crystalSiPMConfig{"12-cross"};
     inline G4bool polishedTyvek{false};
@@ -29,7 +49,12 @@ namespace Configuration
     inline G4int nBins{1000};
     inline G4String outputFile{"GammaCube.root"};
     inline G4bool saveSecondaries{false};
+    inline G4String secondariesFilter{""};  // InteractionFilter spec file, empty = record everything
     inline G4bool savePhotons{false};
+    inline G4int edepSchema{1};  // 2: one event_summary row per event in place of the edep rows
+    inline G4bool asyncOutput{false};  // event-level ntuples written by a writer thread (AsyncWriter)
+    inline G4int asyncBufferMB{64};    // memory shared by the AsyncWriter rings
+    inline G4String outputFormat{"root"};  // gcev: event-level ntuples as mappable column files (GcevStore)
 }
 
 
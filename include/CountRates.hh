@@ -38,9 +38,17 @@ struct FluxParams {
     std::string table_path;
 };
 
+// One species of a composite source: a flux model with its own parameters and energy range (MeV)
+struct FluxComponent {
+    std::string spec; // as listed in Composite_params, e.g. "Galactic:alpha"
+    FluxType type = FluxType::UNIFORM;
+    FluxParams params;
+    EnergyRange eRange{};
+};
+
 struct RateCounts {
-    int crystalOnly = 0;    // N_det (Crystal && !Veto)
-    int crystalAndVeto = 0; // N_det (Crystal && Veto)
+    double crystalOnly = 0;    // N_det (Crystal && !Veto), sum of event weights
+    double crystalAndVeto = 0; // N_det (Crystal && Veto), sum of event weights
 };
 
 struct RateResult {
@@ -56,6 +64,8 @@ double fluxPLAW(double E, double A, double alpha, double E_piv);
 
 double fluxCOMP(double E, double A, double alpha, double E_piv, double E_peak);
 
+std::vector<double> readSepRow(int year, int order, const std::string& csvPath);
+
 double fluxSEP(double E, int year, int order, const std::string& csvPath);
 
 double fluxTable(double E, const std::string& csvPath);
@@ -68,6 +78,13 @@ double J_proton(double E_GeV);
 
 enum class FluxDir { Vertical_down, Vertical_up, Horizontal, Isotropic_up, Isotropic_down, Isotropic };
 
+// Name given to --flux-direction; false for an unknown name, dir is left as it was
+bool fluxDirFromName(const std::string& name, FluxDir& dir);
+
+inline bool isIsotropic(const FluxDir dir) {
+    return dir == FluxDir::Isotropic || dir == FluxDir::Isotropic_up || dir == FluxDir::Isotropic_down;
+}
+
 double Area_cm2(double R_mm, double H_mm, FluxDir dir);
 
 double integrateAdaptiveSimpson(const std::function<double(double)>& f,
@@ -79,7 +96,7 @@ RateResult computeRate(FluxType type,
                        const FluxParams& p,
                        EnergyRange eRange,
                        double A_eff_cm2,
-                       int N_histories,
+                       double N_histories,
                        const RateCounts& detCounts);
 
 RateResult computeRateReal(FluxType type,
@@ -88,5 +105,23 @@ RateResult computeRateReal(FluxType type,
                            const std::vector<double>& Aeff,
                            int nBins);
 
+// "<Type>[:<particle>]", parameters from <configDir><Type>_params.txt
+FluxComponent readFluxComponent(const std::string& spec, const std::string& configDir = "../Flux_config/");
+
+// ∫ flux(E) dE of one component over its range, per cm² (Galactic is converted from m^-2 GeV)
+double componentIntegral(const FluxComponent& c);
+
+// Components are sampled in proportion to their integrals, so the mixture counts as one flux
+RateResult computeRateComposite(const std::vector<FluxComponent>& components,
+                                double A_eff_cm2,
+                                double N_histories,
+                                const RateCounts& detCounts);
+
+// Each component folds its own effective area (Aeff[k] for components[k]) over the bins inside its energy range
+RateResult computeRateRealComposite(const std::vector<FluxComponent>& components,
+                                    EnergyRange eRange,
+                                    const std::vector<std::vector<double>>& Aeff,
+                                    int nBins);
+
 
 #endif //COUNTRATES_HH
@@ -0,0 +1,37 @@
+#ifndef CRYSTALFASTOPTICS_HH
+#define CRYSTALFASTOPTICS_HH
+
+#include <G4VFastSimulationModel.hh>
+#include <G4FastTrack.hh>
+#include <G4FastStep.hh>
+#include <G4Region.hh>
+#include <G4Electron.hh>
+#include <G4LossTableManager.hh>
+#include <G4Material.hh>
+
+#include "LightLUTSampler.hh"
+
+
+// Fast simulation of the crystal's scintillation light (--crystal-fast-optics). An electron whose
+// range is shorter than its distance to the crystal surface is stopped on the spot: its kinetic energy
+// is deposited in one step (so the edep SensitiveDetector still sees it) and its light goes straight to
+// the SiPM channels through the crystal part of the light-collection table, whose probabilities
+// already fold collection efficiency and PDE. No G4OpticalPhoton is made for it.
+// Quenching uses Birks' law with the mean stopping power E / range. Everything else in the crystal,
+// and every veto, keeps full optical tracking.
+class CrystalFastOptics : public G4VFastSimulationModel {
+public:
+    CrystalFastOptics(const G4String &name, G4Region *region);
+
+    G4bool IsApplicable(const G4ParticleDefinition &particle) override;
+    G4bool ModelTrigger(const G4FastTrack &fastTrack) override;
+    void DoIt(const G4FastTrack &fastTrack, G4FastStep &fastStep) override;
+
+private:
+    LightLUTSampler light;
+
+    [[nodiscard]] static G4double Range(const G4Track *track);
+};
+
+
+#endif //CRYSTALFASTOPTICS_HH
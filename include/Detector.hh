@@ -32,6 +32,7 @@
 #include "Sizes.hh"
 #include "Configuration.hh"
 #include "Utils.hh"
+#include "SiPMRegistry.hh"
 
 
 class Detector {
@@ -76,6 +77,7 @@ public:
     [[nodiscard]] std::vector<G4LogicalVolume*> GetSensitiveLV() const;
 
     G4LogicalVolume* GetSiPMWindowLV() const { return SiPMWindowLV; }
+    const SiPMRegistry& GetSiPMRegistry() const { return sipmRegistry; }
 
 private:
     G4ThreeVector crystalSize;
@@ -140,6 +142,9 @@ private:
     G4VPhysicalVolume* bottomVetoSiPMContPVP{};
     G4VPhysicalVolume* bottomVetoSiPMBoardPVP{};
 
+    SiPMRegistry sipmRegistry;
+    void RegisterSiPM(const G4VPhysicalVolume* windowPVP, const G4VPhysicalVolume* bodyPVP, SiPMGroup group, int ch);
+
     void ConstructCrystal();
     void ConstructShell();
     void ConstructVeto();
@@ -7,6 +7,7 @@
 #include <G4Event.hh>
 #include <G4Run.hh>
 #include <G4RunManager.hh>
+#include <G4EventManager.hh>
 #include <G4SDManager.hh>
 #include <G4HCofThisEvent.hh>
 #include <G4SystemOfUnits.hh>
@@ -20,34 +21,24 @@
 #include "AnalysisManager.hh"
 #include "SDHit.hh"
 #include "SiPMOpticalSD.hh"
+#include "InteractionBuffer.hh"
+#include "LightCalibration.hh"
+#include "PhotonPolicy.hh"
 
 class G4Event;
 class Geometry;
+class SiPMOpticalSD;
 
 struct PrimaryRec {
     int index = 0;
     int pdg = 0;
-    G4String name;
+    const G4ParticleDefinition *def = nullptr;
     double E_MeV = 0.0;
     G4ThreeVector dir;
     G4ThreeVector pos_mm;  // mm
     double t0_ns = 0.0;    // ns
-};
-
-struct InteractionRec {
-    int trackID = -1;
-    int parentID = -1;
-    G4String process;
-    G4String volumeName;
-    int volumeID = -1;
-    G4ThreeVector pos_mm;  // mm
-    double t_ns = 0.0;     // ns
-
-    int secIndex = -1;
-    int secPDG = 0;
-    G4String secName;
-    double secE_MeV = 0.0;
-    G4ThreeVector secDir;
+    double weight = 1.0;   // importance weight of the sampled energy
+    int species = 0;       // component of a composite source
 };
 
 struct PhotonRec {
@@ -61,9 +52,11 @@ struct PhotonRec {
 class EventAction : public G4UserEventAction {
 public:
     std::vector<PrimaryRec> primBuf;
-    std::vector<InteractionRec> interBuf;
-    std::vector<G4int> photonCountBuf{0, 0, 0};
+    InteractionBuffer interBuf;
+    std::vector<G4double> photonCountBuf{0, 0, 0};  // weighted photons born per subdetector
     std::vector<PhotonRec> photonBuf;
+    LUTEmission lutEmission;  // --lut-calibrate: what this event shot
+    PhotonLoss photonLoss;    // --photon-policy: what this event killed
 
     EventAction(AnalysisManager *, RunAction *);
     ~EventAction() override = default;
@@ -71,6 +64,11 @@ public:
     void BeginOfEventAction(const G4Event *) override;
     void EndOfEventAction(const G4Event *) override;
 
+    // --early-abort: a veto has crossed its edep (optical = false) or npe threshold. Nothing tracked later
+    // can make the event crystalOnly, so it is aborted once every recorded classification (edep, and npe
+    // with optics) has its veto set.
+    void VetoFired(G4bool optical);
+
 private:
     void WritePrimaries_(int eventID);
     int WriteInteractions_(int eventID);
@@ -79,6 +77,7 @@ private:
     int WriteEdepFromSD_(const G4Event *evt, int eventID);
 
     void WriteSiPMFromSD_(int eventID);
+    void WriteEventSummary_(int eventID, double primaryE_MeV, int species);
 
     void MarkCrystal() { hasCrystal = true; }
     void MarkVeto() { hasVeto = true; }
@@ -92,17 +91,23 @@ private:
     std::vector<std::tuple<G4String, int, G4String>> optMap;
     std::vector<int> optHCIDs;
     std::vector<int> HCIDs;
+    SiPMOpticalSD *sipmSD = nullptr;  // this thread's SD, looked up on the first optical event
 
     int nPrimaries = 0;
     int nInteractions = 0;
     int nPhotons = 0;
     int nEdepHits = 0;
+    double edepSum[3]{};  // MeV over threshold per subdetector, for --edep-schema 2
+    double npeSum[3]{};   // npe over threshold per subdetector, for --edep-schema 2
 
     RunAction* run = nullptr;
     bool hasCrystal = false;
     bool hasVeto = false;
     bool hasCrystalOpt = false;
     bool hasVetoOpt = false;
+    bool vetoEdepFired = false;
+    bool vetoNpeFired = false;
+    bool abortRequested = false;
 };
 
 #endif //EVENTACTION_HH
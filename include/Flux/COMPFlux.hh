@@ -6,7 +6,7 @@
 
 class COMPFlux : public Flux {
 public:
-    explicit COMPFlux(G4double cThreshold);
+    explicit COMPFlux(G4double cThreshold, std::shared_ptr<const Spectrum> shared = nullptr);
 
 private:
     G4double alpha{};
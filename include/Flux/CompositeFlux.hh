@@ -0,0 +1,34 @@
+#ifndef COMPOSITEFLUX_HH
+#define COMPOSITEFLUX_HH
+
+#include "Flux/Flux.hh"
+#include "CountRates.hh"
+
+
+// Several species in one run, e.g. "components: Galactic:proton, Galactic:alpha, Galactic:e-, SEP".
+// A primary first picks its component with probability proportional to the component's integrated flux,
+// then the component samples it; ParticleInfo::species is the index in the components list.
+class CompositeFlux : public Flux {
+public:
+    // shared[i], when given, is the spectrum of component i built on the master (see Spectra())
+    explicit CompositeFlux(G4double cThreshold, const SharedSpectra &shared = {});
+
+    [[nodiscard]] SharedSpectra Spectra() const override;
+
+    ParticleInfo GenerateParticle() override;
+    ParticleInfo GenerateSpecies() override;
+    void SetEnergyBias(const G4String &bias) override;
+
+    [[nodiscard]] size_t Size() const { return components.size(); }
+    [[nodiscard]] G4double Fraction(const size_t i) const { return fractions[i]; }
+
+private:
+    std::vector<std::unique_ptr<Flux>> components;
+    std::vector<G4double> fractions;
+    AliasTable table;
+
+    G4double SampleEnergy() override;
+};
+
+
+#endif //COMPOSITEFLUX_HH
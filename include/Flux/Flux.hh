@@ -11,13 +11,20 @@
 #include <vector>
 #include <string>
 #include <numeric>
+#include <memory>
 #include <unordered_map>
 
+#include "Flux/Spectrum.hh"
+
+// Spectra built on the master and shared read-only by the workers, one per component of a composite
+using SharedSpectra = std::vector<std::shared_ptr<const Spectrum>>;
+
 struct ParticleInfo {
-    G4String name;
     G4int pdg;
-    G4ParticleDefinition *def;
+    G4ParticleDefinition *def;  // name via def->GetParticleName()
     G4double energy;
+    G4double weight = 1.0;  // importance weight of the sampled energy
+    G4int species = 0;      // component of a composite source, 0 for single-species fluxes
 };
 
 
@@ -26,6 +33,18 @@ public:
     virtual ~Flux() = default;
 
     virtual ParticleInfo GenerateParticle();
+    // Particle and species only, for callers that draw the energy themselves (--energy-bias stratified)
+    virtual ParticleInfo GenerateSpecies();
+
+    // Builds the flux by its config name; tabulated fluxes reuse shared spectra instead of rebuilding them
+    static Flux *Create(const G4String &type, G4double cThreshold, const SharedSpectra &shared = {});
+
+    [[nodiscard]] const std::shared_ptr<const Spectrum> &GetSpectrum() const { return spectrum; }
+    // What Create takes back on another thread: this flux's spectrum, or one per component
+    [[nodiscard]] virtual SharedSpectra Spectra() const { return {spectrum}; }
+
+    // "none" samples the spectrum itself, "logflat" samples log-uniform energies with compensating weights
+    virtual void SetEnergyBias(const G4String &bias) { logFlat = bias == "logflat"; }
 
 protected:
     G4String particle;
@@ -33,7 +52,17 @@ protected:
     G4double Emin{};
     G4double Emax{};
 
+    std::shared_ptr<const Spectrum> spectrum;
+    G4double spectrumUnit{1.0};  // energy unit of the spectrum grid
+    G4bool logFlat{false};
+
     virtual G4double SampleEnergy() = 0;
+    // Definition of the particle just sampled; `particle` is looked up once, on the first event
+    virtual G4ParticleDefinition *Definition();
+    // Energy drawn log-uniformly over the flux range, weight = true / sampling density
+    virtual G4double SampleLogFlat(G4double &weight);
+    // Takes a spectrum built here, on the master or read from a .gcspec file, and its Emin/Emax with it
+    void UseSpectrum(std::shared_ptr<const Spectrum> s);
 
     static G4String Trim(const G4String &);
 
@@ -44,8 +73,11 @@ protected:
                       const G4String &,
                       G4double);
 
+    static G4ParticleDefinition *FindDefinition(const G4String &name);
+
 private:
     std::unordered_map<std::string, std::string> cache{};
+    G4ParticleDefinition *definition{nullptr};
 
     void LoadFileIfNeeded(const G4String &);
 };
@@ -6,7 +6,9 @@
 
 class GalacticFlux : public Flux {
 public:
-    explicit GalacticFlux(G4double cThreshold);
+    // particleName overrides the particle of Galactic_params (one species of a composite source)
+    explicit GalacticFlux(G4double cThreshold, std::shared_ptr<const Spectrum> shared = nullptr,
+                          const G4String &particleName = "");
 
 private:
     G4double phiMV{};
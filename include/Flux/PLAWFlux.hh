@@ -11,6 +11,7 @@ private:
     G4double alpha{};
 
     G4double SampleEnergy() override;
+    G4double SampleLogFlat(G4double &weight) override;
 };
 
 
@@ -2,6 +2,8 @@
 #define SEPFLUX_HH
 
 #include "Flux.hh"
+#include "Flux/SpectrumFile.hh"
+#include "CountRates.hh"
 
 #include <fstream>
 #include <regex>
@@ -14,17 +16,20 @@ struct Row {
 
 class SEPFlux : public Flux {
 public:
-    explicit SEPFlux(G4double cThreshold);
+    explicit SEPFlux(G4double cThreshold, std::shared_ptr<const Spectrum> shared = nullptr);
 
 private:
     std::string path;
+    std::string coeffPath;
     G4int year{};
     G4int order{};
 
     std::vector<G4double> EList;
     std::vector<G4double> CDF;
 
-    void BuildCDF();
+    [[nodiscard]] std::vector<Row> ReadRows() const;
+
+    void BuildCDF(std::vector<Row> rows);
 
     G4double SampleEnergy() override;
 };
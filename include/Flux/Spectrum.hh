@@ -0,0 +1,99 @@
+#ifndef SPECTRUM_HH
+#define SPECTRUM_HH
+
+#include <G4Types.hh>
+#include <Randomize.hh>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+
+// Discrete distribution over [0, N) sampled in constant time (Walker/Vose alias method).
+class AliasTable {
+public:
+    AliasTable() = default;
+    explicit AliasTable(const std::vector<G4double> &weights);
+    // Non-owning view over an existing table, e.g. a memory-mapped .gcspec file
+    AliasTable(const G4double *prob, const G4int *alias, size_t n) : prob(prob), alias(alias), n(n) {}
+
+    // Moving a std::vector keeps its buffer, so the views stay valid; copying would not
+    AliasTable(AliasTable &&) noexcept = default;
+    AliasTable &operator=(AliasTable &&) noexcept = default;
+    AliasTable(const AliasTable &) = delete;
+    AliasTable &operator=(const AliasTable &) = delete;
+
+    [[nodiscard]] size_t Size() const { return n; }
+    [[nodiscard]] const G4double *Prob() const { return prob; }
+    [[nodiscard]] const G4int *Alias() const { return alias; }
+
+    // u is a uniform deviate in [0, 1)
+    [[nodiscard]] size_t Sample(G4double u) const {
+        const G4double x = u * static_cast<G4double>(n);
+        const size_t i = std::min(static_cast<size_t>(x), n - 1);
+        return x - static_cast<G4double>(i) < prob[i] ? i : static_cast<size_t>(alias[i]);
+    }
+
+private:
+    std::vector<G4double> probStore;
+    std::vector<G4int> aliasStore;
+
+    const G4double *prob{nullptr};
+    const G4int *alias{nullptr};
+    size_t n{0};
+};
+
+
+// Tabulated energy spectrum given by a grid E[i] and its CDF.
+// A bin is picked from the alias table, the energy inside the bin is log-linear.
+// Emin/Emax are the bounds the owning flux ended up with after building the grid, so that a flux
+// taking the spectrum from the master or from a .gcspec file restores the same range.
+class Spectrum {
+public:
+    Spectrum() = default;
+    Spectrum(const std::vector<G4double> &E, const std::vector<G4double> &cdf, G4double Emin, G4double Emax);
+    // View over arrays owned by storage (kept alive as long as the spectrum)
+    Spectrum(std::shared_ptr<const void> storage, const G4double *logE, const G4double *cdf, size_t n,
+             const G4double *prob, const G4int *alias, G4double Emin, G4double Emax);
+
+    [[nodiscard]] bool Empty() const { return n < 2; }
+    [[nodiscard]] size_t Size() const { return n; }
+    [[nodiscard]] const G4double *LogE() const { return logE; }
+    [[nodiscard]] const G4double *CDF() const { return cdf; }
+    [[nodiscard]] const AliasTable &Table() const { return table; }
+    [[nodiscard]] G4double Emin() const { return eMin; }
+    [[nodiscard]] G4double Emax() const { return eMax; }
+
+    [[nodiscard]] G4double Sample() const {
+        const size_t i = table.Sample(G4UniformRand());
+        const G4double t = G4UniformRand();
+        return std::exp(logE[i] + t * (logE[i + 1] - logE[i]));
+    }
+
+    // Probability density per unit ln E, consistent with Sample()
+    [[nodiscard]] G4double DensityLnE(G4double lnE) const;
+
+    // Log-uniform over the grid; weight is the ratio of the true to the sampling density
+    [[nodiscard]] G4double SampleLogFlat(G4double &weight) const {
+        const G4double span = logE[n - 1] - logE[0];
+        const G4double lnE = logE[0] + G4UniformRand() * span;
+        weight = DensityLnE(lnE) * span;
+        return std::exp(lnE);
+    }
+
+private:
+    std::vector<G4double> logEStore;
+    std::vector<G4double> cdfStore;
+    std::shared_ptr<const void> storage;
+
+    const G4double *logE{nullptr};
+    const G4double *cdf{nullptr};
+    size_t n{0};
+    G4double eMin{0};
+    G4double eMax{0};
+
+    AliasTable table;
+};
+
+
+#endif //SPECTRUM_HH
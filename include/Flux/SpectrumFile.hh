@@ -0,0 +1,100 @@
+#ifndef SPECTRUMFILE_HH
+#define SPECTRUMFILE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Flux/Spectrum.hh"
+
+
+// Precompiled binary spectrum (.gcspec), memory-mapped read-only so that all threads and jobs share the pages.
+//
+// Layout (native endianness, 8-byte aligned):
+//   Header
+//   double rawE[nRaw], rawFlux[nRaw]   source table as read from the CSV
+//   double logE[nGrid], cdf[nGrid]     sampling grid built for [Emin, Emax]
+//   double prob[nGrid - 1]             alias table over the grid bins
+//   double aux[nAux]                   extra numbers, e.g. SEP polynomial coefficients
+//   int32  alias[nGrid - 1]
+// The checksum is FNV-1a over everything after the header.
+class SpectrumFile : public std::enable_shared_from_this<SpectrumFile> {
+public:
+    static constexpr std::uint32_t Version = 2;
+
+    // Parameters the sampling grid was built for
+    struct Key {
+        double Emin = 0.0;
+        double Emax = 0.0;
+        std::int32_t year = 0;
+        std::int32_t order = 0;
+
+        bool operator==(const Key &other) const {
+            return Emin == other.Emin && Emax == other.Emax && year == other.year && order == other.order;
+        }
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t nRaw;
+        std::uint32_t nGrid;
+        std::uint32_t nAux;
+        Key key;
+        double Emin;  // bounds of the flux after the grid was built, see Spectrum
+        double Emax;
+        std::uint64_t payloadBytes;
+        std::uint64_t checksum;
+    };
+
+    ~SpectrumFile();
+
+    SpectrumFile(const SpectrumFile &) = delete;
+    SpectrumFile &operator=(const SpectrumFile &) = delete;
+
+    // Maps the file; nullptr if it is missing, corrupt or older than any of the sources
+    static std::shared_ptr<const SpectrumFile> Open(const std::string &path,
+                                                    const std::vector<std::string> &sources);
+
+    // Writes through a temporary file and renames it, so concurrent jobs never see a partial file
+    static bool Write(const std::string &path, const Key &key,
+                      const std::vector<double> &rawE, const std::vector<double> &rawFlux,
+                      const Spectrum &spectrum, const std::vector<double> &aux = {});
+
+    // "dir/name.csv" -> "dir/name.gcspec", or "dir/<stem>.gcspec" when a stem is given
+    static std::string PathFor(const std::string &source, const std::string &stem = "");
+
+    [[nodiscard]] const Key &GetKey() const { return header->key; }
+
+    [[nodiscard]] size_t RawSize() const { return header->nRaw; }
+    [[nodiscard]] const double *RawE() const { return rawE; }
+    [[nodiscard]] const double *RawFlux() const { return rawFlux; }
+
+    [[nodiscard]] size_t AuxSize() const { return header->nAux; }
+    [[nodiscard]] const double *Aux() const { return aux; }
+
+    // Spectrum viewing the mapped grid; keeps the mapping alive
+    [[nodiscard]] std::shared_ptr<const Spectrum> MakeSpectrum() const;
+
+private:
+    SpectrumFile() = default;
+
+    void *base{nullptr};
+    size_t size{0};
+
+    const Header *header{nullptr};
+    const double *rawE{nullptr};
+    const double *rawFlux{nullptr};
+    const double *logE{nullptr};
+    const double *cdf{nullptr};
+    const double *prob{nullptr};
+    const double *aux{nullptr};
+    const std::int32_t *alias{nullptr};
+
+    static std::uint64_t Checksum(const unsigned char *data, size_t n);
+};
+
+
+#endif //SPECTRUMFILE_HH
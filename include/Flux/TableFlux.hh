@@ -16,11 +16,12 @@
 
 #include "Flux/Flux.hh"
 #include "Flux/SEPFlux.hh"
+#include "Flux/SpectrumFile.hh"
 
 
 class TableFlux : public Flux {
 public:
-    explicit TableFlux(G4double cThreshold);
+    explicit TableFlux(G4double cThreshold, std::shared_ptr<const Spectrum> shared = nullptr);
 
 private:
     G4String path;
@@ -28,7 +29,9 @@ private:
     std::vector<G4double> EList;
     std::vector<G4double> CDF;
 
-    void BuildCDF();
+    [[nodiscard]] std::vector<Row> ReadRows() const;
+
+    void BuildCDF(std::vector<Row> rows);
 
     G4double SampleEnergy() override;
 };
@@ -7,18 +7,23 @@ class UniformFlux : public Flux {
 public:
     explicit UniformFlux(G4double cThreshold);
 
+    ParticleInfo GenerateSpecies() override;
+
 private:
     std::vector<G4String> particles;
     std::vector<G4double> fractions;
     std::vector<G4double> EminVec;
     std::vector<G4double> EmaxVec;
     G4double eCrystalThreshold;
+    size_t current{0};
+    std::vector<G4ParticleDefinition *> definitions;
 
     static std::vector<G4String> Split(const G4String &line);
     static std::vector<G4double> ParseDoubles(const G4String &line);
     size_t SampleIndex() const;
 
     G4double SampleEnergy() override;
+    G4ParticleDefinition *Definition() override;
 };
 
 
@@ -0,0 +1,58 @@
+#ifndef GCEVREADER_HH
+#define GCEVREADER_HH
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+// Reads a --format gcev directory (see GcevStore): index.json is parsed once, the column files are
+// mapped read-only on first use and stay mapped until the reader goes away. Needs neither ROOT nor
+// Geant4. Throws std::runtime_error on a missing or malformed store.
+class GcevReader {
+public:
+    struct Column {
+        std::string name;
+        std::string type;                     // i4, f4 or f8
+        bool encoded = false;                 // a string column, stored as i4 codes
+        std::vector<std::string> dictionary;  // the text of every code
+        [[nodiscard]] size_t Width() const { return type == "f8" ? 8 : 4; }
+    };
+
+    struct Segment {
+        int thread = 0;
+        size_t rows = 0;
+    };
+
+    struct Table {
+        std::string name;
+        std::string title;
+        std::vector<Column> columns;
+        std::vector<Segment> segments;
+    };
+
+    explicit GcevReader(std::string dir);
+    ~GcevReader();
+
+    GcevReader(const GcevReader &) = delete;
+    GcevReader &operator=(const GcevReader &) = delete;
+
+    [[nodiscard]] const Table *Find(const std::string &name) const;
+
+    // Rows x Width() bytes of one column of one segment; nullptr for an empty segment. The same pointer on every call
+    const void *Map(const Table &table, size_t column, size_t segment);
+
+private:
+    struct Mapping {
+        void *base;
+        size_t size;
+    };
+
+    std::string dir;
+    std::vector<Table> tables;
+    std::map<std::tuple<std::string, size_t, size_t>, Mapping> mappings;  // by table, column, segment
+};
+
+#endif //GCEVREADER_HH
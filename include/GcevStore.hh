@@ -0,0 +1,69 @@
+#ifndef GCEVSTORE_HH
+#define GCEVSTORE_HH
+
+#include "NtupleSchema.hh"
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4AutoLock.hh>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+// --format gcev: the event-level ntuples as a directory of raw columns in native byte order, one file per
+// table, column and thread (<table>.<column>.<thread>.col), plus index.json with the schema, the row
+// count of every file and the dictionaries of the string columns, which are stored as int32 codes.
+// The files are append-only and fixed-width, so a reader maps them and indexes them directly.
+class GcevStore {
+public:
+    static G4String DirFor(const G4String &outputFile);
+
+    // Master only: before the workers start, and after they have all closed their writers
+    static void Begin(const G4String &dir);
+    static void WriteIndex(const G4String &dir);
+
+    static G4int Intern(G4int table, const G4String &text);
+    static void AddSegment(G4int table, G4int thread, size_t rows);
+
+private:
+    struct Segment {
+        G4int thread;
+        size_t rows;
+    };
+
+    static G4Mutex mutex;
+    static std::vector<std::vector<G4String>> dictionaries;  // by table, code = position
+    static std::vector<std::unordered_map<std::string, G4int>> codes;
+    static std::vector<std::vector<Segment>> segments;
+};
+
+
+// One per thread; the thread is the file suffix, 0 for the master and 1 + id for the workers
+class GcevWriter {
+public:
+    GcevWriter(const G4String &dir, G4int thread);
+    ~GcevWriter();
+
+    void Append(const NtupleRecord &record);
+    void Close();
+
+private:
+    struct Sink {
+        NtupleSchema::Table table;
+        std::vector<std::FILE *> files;
+        std::vector<std::vector<char>> buffers;
+        std::unordered_map<std::string, G4int> codes;  // this thread's copy of the dictionary
+        size_t rows = 0;
+    };
+
+    G4String dir;
+    G4int thread;
+    std::vector<Sink> sinks;  // by table, opened on the first row
+
+    Sink &Open(G4int table);
+    static void Flush(std::FILE *file, std::vector<char> &buffer);
+};
+
+#endif //GCEVSTORE_HH
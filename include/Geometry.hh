@@ -19,9 +19,11 @@
 #include <G4VSolid.hh>
 #include <G4PhysicalConstants.hh>
 #include <G4SDManager.hh>
+#include <G4RegionStore.hh>
 #include <utility>
 
 #include "SensitiveDetector.hh"
+#include "CrystalFastOptics.hh"
 #include "Detector.hh"
 #include "Sizes.hh"
 #include "Configuration.hh"
@@ -76,6 +78,7 @@ private:
 
     G4UserLimits* vetoStepLimit;
     G4Region* vetoRegion;
+    G4Region* crystalRegion{nullptr};  // envelope of CrystalFastOptics
     G4ProductionCuts* vetoCuts;
 
     G4VisAttributes* tunaCanVisAttr;
@@ -0,0 +1,51 @@
+#ifndef INTERACTIONBUFFER_HH
+#define INTERACTIONBUFFER_HH
+
+#include <G4Types.hh>
+#include <G4ThreeVector.hh>
+#include <vector>
+
+
+// Interactions of the current event, one column per field; names are InteractionCodes.
+// Rows without a secondary have secIndex -1, secCode -1 and zero energy and direction.
+struct InteractionBuffer {
+    std::vector<G4int> trackID, parentID;
+    std::vector<G4int> processCode, volumeCode, volumeCopy;
+    std::vector<G4double> x_mm, y_mm, z_mm, t_ns;
+    std::vector<G4int> secIndex, secPDG, secCode;
+    std::vector<G4double> secE_MeV, secDirX, secDirY, secDirZ;
+
+    [[nodiscard]] size_t size() const { return trackID.size(); }
+
+    void Add(G4int track, G4int parent, G4int process, G4int volume, G4int copyNo,
+             const G4ThreeVector &pos_mm, G4double time_ns,
+             G4int index, G4int pdg, G4int particle, G4double E_MeV, const G4ThreeVector &dir) {
+        trackID.push_back(track);
+        parentID.push_back(parent);
+        processCode.push_back(process);
+        volumeCode.push_back(volume);
+        volumeCopy.push_back(copyNo);
+        x_mm.push_back(pos_mm.x());
+        y_mm.push_back(pos_mm.y());
+        z_mm.push_back(pos_mm.z());
+        t_ns.push_back(time_ns);
+        secIndex.push_back(index);
+        secPDG.push_back(pdg);
+        secCode.push_back(particle);
+        secE_MeV.push_back(E_MeV);
+        secDirX.push_back(dir.x());
+        secDirY.push_back(dir.y());
+        secDirZ.push_back(dir.z());
+    }
+
+    // Keeps the capacity for the next event
+    void clear() {
+        for (auto *v: {&trackID, &parentID, &processCode, &volumeCode, &volumeCopy, &secIndex, &secPDG, &secCode}) {
+            v->clear();
+        }
+        for (auto *v: {&x_mm, &y_mm, &z_mm, &t_ns, &secE_MeV, &secDirX, &secDirY, &secDirZ}) v->clear();
+    }
+};
+
+
+#endif //INTERACTIONBUFFER_HH
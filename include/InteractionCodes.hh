@@ -0,0 +1,42 @@
+#ifndef INTERACTIONCODES_HH
+#define INTERACTIONCODES_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4VProcess.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4ParticleDefinition.hh>
+#include <G4AutoLock.hh>
+#include <unordered_map>
+#include <vector>
+
+
+enum class CodeKind { Process, Volume, Particle };
+
+// Small integer codes for the process, volume and particle names of the interactions ntuple.
+// Codes are shared by all threads so that merged worker ntuples agree: the name table is global and
+// mutex-protected, and every thread keeps a pointer -> code cache in front of it, so a step only
+// touches the table the first time it meets a new process, volume or particle.
+class InteractionCodes {
+public:
+    G4int Process(const G4VProcess *p) { return Lookup(CodeKind::Process, p, p ? p->GetProcessName() : Unknown); }
+    G4int Volume(const G4VPhysicalVolume *pv) { return Lookup(CodeKind::Volume, pv, pv ? pv->GetName() : World); }
+    G4int Particle(const G4ParticleDefinition *d) { return Lookup(CodeKind::Particle, d, d->GetParticleName()); }
+
+    // Code of a name, registering it if needed
+    static G4int Code(CodeKind kind, const G4String &name);
+    // Names in code order: the dictionary written next to the interactions ntuple
+    static std::vector<G4String> Names(CodeKind kind);
+    static const char *KindName(CodeKind kind);
+
+private:
+    static inline const G4String Unknown{"unknown"};
+    static inline const G4String World{"World"};
+
+    std::unordered_map<const void *, G4int> cache[3];
+
+    G4int Lookup(CodeKind kind, const void *key, const G4String &name);
+};
+
+
+#endif //INTERACTIONCODES_HH
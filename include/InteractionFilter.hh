@@ -0,0 +1,48 @@
+#ifndef INTERACTIONFILTER_HH
+#define INTERACTIONFILTER_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4SystemOfUnits.hh>
+#include <vector>
+
+#include "InteractionCodes.hh"
+
+
+// Which interactions --save-secondaries records. The spec file lists
+//   volumes:   CrystalPVP, VetoPVP      physical volume of the step
+//   processes: compt, phot, conv        process of the step, or the creator of a secondary
+//   particles: gamma, e-                secondary species, or the stepping particle for rows without one
+//   E_min:     0.01                     minimum secondary kinetic energy, MeV
+//   max_depth: 1                        generation of the stepping track, 0 = primary
+// and a missing key does not restrict. Names are compiled into masks over InteractionCodes codes,
+// so a step is tested with a few indexed loads.
+class InteractionFilter {
+public:
+    // Empty path: everything passes
+    explicit InteractionFilter(const G4String &path = "");
+
+    [[nodiscard]] G4bool Volume(const G4int code) const { return Pass(volumes, code); }
+    [[nodiscard]] G4bool Process(const G4int code) const { return Pass(processes, code); }
+    [[nodiscard]] G4bool Particle(const G4int code) const { return Pass(particles, code); }
+    [[nodiscard]] G4bool Energy(const G4double E) const { return E >= eMin; }
+    [[nodiscard]] G4bool Depth(const G4int depth) const { return maxDepth < 0 || depth <= maxDepth; }
+
+    [[nodiscard]] G4bool UsesDepth() const { return maxDepth >= 0; }
+
+private:
+    // Indexed by code; empty = no restriction
+    std::vector<char> volumes;
+    std::vector<char> processes;
+    std::vector<char> particles;
+    G4double eMin{0};
+    G4int maxDepth{-1};
+
+    static G4bool Pass(const std::vector<char> &mask, const G4int code) {
+        return mask.empty() || (code >= 0 && code < static_cast<G4int>(mask.size()) && mask[code]);
+    }
+    static std::vector<char> Compile(CodeKind kind, const G4String &line);
+};
+
+
+#endif //INTERACTIONFILTER_HH
@@ -0,0 +1,64 @@
+#ifndef LIGHTCALIBRATION_HH
+#define LIGHTCALIBRATION_HH
+
+#include <G4Event.hh>
+#include <G4PrimaryVertex.hh>
+#include <G4PrimaryParticle.hh>
+#include <G4OpticalPhoton.hh>
+#include <G4VSolid.hh>
+#include <G4LogicalVolume.hh>
+#include <G4Material.hh>
+#include <G4MaterialPropertiesTable.hh>
+#include <G4PhysicalConstants.hh>
+#include <Randomize.hh>
+#include <vector>
+
+#include "LightLUT.hh"
+#include "Configuration.hh"
+
+
+// Photons shot by one calibration event, tallied against the SiPM response in EventAction
+struct LUTEmission {
+    G4int source{-1};
+    G4int voxel{-1};
+    G4int emitted{0};
+};
+
+
+// Primary source of --lut-calibrate runs. Every event shoots Configuration::lutPhotons optical photons,
+// isotropic and with the scintillator's emission spectrum, from uniform points of one voxel of one
+// scintillator. The voxel follows the event ID through the voxels that overlap their solid, so a run of
+// a multiple of NVoxels() events covers the grid evenly whatever the threads.
+class LightCalibration {
+public:
+    LightCalibration();
+
+    LUTEmission Generate(G4Event *evt);
+    [[nodiscard]] size_t NVoxels() const { return voxels.size(); }
+
+private:
+    // Inverse-CDF sampler of one emission component, on the points of its property vector
+    struct Spectrum {
+        std::vector<G4double> e, cdf;
+        G4double Sample(G4double u) const;
+    };
+
+    struct Emitter {
+        const G4VSolid *solid{nullptr};
+        std::vector<G4AffineTransform> toWorld;
+        Spectrum fast, slow;
+        G4double slowShare{0};
+    };
+
+    static constexpr G4int maxTries = 1000;
+
+    LightLUT grid;
+    Emitter emitters[LightLUT::nSources];
+    std::vector<std::pair<G4int, G4int>> voxels;  // (source, voxel) with some volume inside the solid
+
+    G4bool Inside(G4int source, G4int voxel, G4ThreeVector &local) const;
+    static Spectrum MakeSpectrum(const G4MaterialPropertiesTable *mpt, const char *key);
+};
+
+
+#endif //LIGHTCALIBRATION_HH
@@ -0,0 +1,78 @@
+#ifndef LIGHTLUT_HH
+#define LIGHTLUT_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4ThreeVector.hh>
+#include <G4AffineTransform.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4PhysicalVolumeStore.hh>
+#include <G4AutoLock.hh>
+#include <G4SystemOfUnits.hh>
+#include <G4Exception.hh>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+
+enum class SiPMGroup;
+class SiPMOpticalSD;
+
+
+// Light-collection lookup table: for a photon born in a voxel of a scintillator, the probability that
+// it is detected on each SiPM channel. Voxels live in the local frame of the scintillator's solid, so
+// a step only needs its touchable's top transform to find its voxel.
+//
+// The table is written by a calibration run (--lut-calibrate), which shoots photons from every voxel
+// and tallies detections in a global, mutex-protected accumulator, and read by production runs
+// (--light-lut), which share one loaded copy between threads.
+class LightLUT {
+public:
+    // Scintillators photons are emitted from, in SensitiveDetector detID order
+    static constexpr G4int nSources = 3;
+    static constexpr const char *SourcePV[nSources] = {"CrystalPVP", "VetoPVP", "BottomVetoPVP"};
+
+    struct Channel {
+        SiPMGroup group;
+        G4int ch;
+    };
+
+    struct Source {
+        G4int nx{0}, ny{0}, nz{0};
+        G4ThreeVector lo, hi;              // local bounding box, mm
+        std::vector<Channel> channels;     // columns of prob
+        std::vector<G4double> emitted;     // photons shot per voxel in the calibration
+        std::vector<G4double> prob;        // voxel-major, channels.size() per voxel
+
+        [[nodiscard]] G4int NVoxels() const { return nx * ny * nz; }
+        // Voxel of a local point, -1 outside the grid
+        [[nodiscard]] G4int Voxel(const G4ThreeVector &local) const;
+        [[nodiscard]] G4ThreeVector VoxelLow(G4int voxel) const;
+        [[nodiscard]] G4ThreeVector VoxelSize() const;
+    };
+
+    Source sources[nSources];
+
+    // Default table file for the current detector type and crystal SiPM configuration
+    static G4String DefaultPath();
+
+    // Loaded once per process and shared read-only; fatal if the file is missing or malformed
+    static std::shared_ptr<const LightLUT> Shared(const G4String &path);
+
+    // Local -> world transform of a placed volume, composed up its mother chain
+    static std::vector<G4AffineTransform> ToWorld(const G4VPhysicalVolume *pv);
+
+    // Calibration tally, shared by all threads
+    static void BeginCalibration(const LightLUT &grid);
+    static void Tally(G4int source, G4int voxel, G4double emitted, const SiPMOpticalSD &sd);
+    static void WriteCalibration(const G4String &path);
+
+private:
+    void Read(std::istream &in, const G4String &path);
+    void Write(std::ostream &out) const;
+};
+
+
+#endif //LIGHTLUT_HH
@@ -0,0 +1,49 @@
+#ifndef LIGHTLUTSAMPLER_HH
+#define LIGHTLUTSAMPLER_HH
+
+#include <G4Step.hh>
+#include <G4Material.hh>
+#include <G4MaterialPropertiesTable.hh>
+#include <G4NavigationHistory.hh>
+#include <G4SDManager.hh>
+#include <G4Poisson.hh>
+#include <Randomize.hh>
+#include <memory>
+
+#include "LightLUT.hh"
+#include "Configuration.hh"
+#include "SiPMOpticalSD.hh"
+
+
+// Optical response of one scintillator drawn from the light-collection table, used by every
+// SensitiveDetector step of --light-lut runs and by CrystalFastOptics. Instead of tracking photons,
+// a deposit draws its photon count as G4Scintillation would (yield, Birks quenching, resolution scale)
+// and then the p.e. on each channel from the detection probabilities of its voxel. The result goes to
+// SiPMOpticalSD, so sipm_event/sipm_ch are filled as in a tracked run.
+// Times are those of the deposit: the scintillation decay and photon transit are not modelled.
+class LightLUTSampler {
+public:
+    explicit LightLUTSampler(G4int source);
+
+    void Deposit(const G4Step *step);
+    // Visible (already quenched) energy at a point of the scintillator's local frame
+    void Deposit(const G4Material *mat, G4double visibleE, const G4ThreeVector &local, G4double t);
+
+private:
+    std::shared_ptr<const LightLUT> lut;
+    const LightLUT::Source *src;
+    SiPMOpticalSD *sipmSD = nullptr;  // this thread's SD, looked up on the first deposit
+
+    // Scintillation constants of the material, read on the first deposit
+    const G4Material *material = nullptr;
+    G4double yield{0};
+    G4double resolution{1};
+    G4double birks{0};
+
+    void ReadMaterial(const G4Material *mat);
+    void Emit(G4double visibleE, const G4ThreeVector &local, G4double t);
+    [[nodiscard]] G4double VisibleEnergy(const G4Step *step) const;
+};
+
+
+#endif //LIGHTLUTSAMPLER_HH
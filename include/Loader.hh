@@ -13,6 +13,7 @@
 #include <G4OpticalPhysics.hh>
 #include <G4OpticalParameters.hh>
 #include <G4StepLimiterPhysics.hh>
+#include <G4FastSimulationPhysics.hh>
 #include <G4EmStandardPhysics_option4.hh>
 #include <G4Types.hh>
 #include <G4RadioactiveDecayPhysics.hh>
@@ -32,6 +33,7 @@
 #include "ActionInitialization.hh"
 #include "CountRates.hh"
 #include "PostProcessing.hh"
+#include "LightLUT.hh"
 
 #ifdef G4MULTITHREADED
 #include <G4MTRunManager.hh>
@@ -63,10 +65,13 @@ public:
 
 private:
     std::string configPath;
-    G4int crystalOnly{};
-    G4int crystalAndVeto{};
-    G4int crystalOnlyOpt{};
-    G4int crystalAndVetoOpt{};
+    G4double crystalOnly{};
+    G4double crystalAndVeto{};
+    G4double crystalOnlyOpt{};
+    G4double crystalAndVetoOpt{};
+    G4double culled{};
+    G4double aborted{};
+    std::vector<SpeciesCounts> speciesCounts;
 
     std::string geomConfigPath;
 
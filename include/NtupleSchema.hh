@@ -0,0 +1,59 @@
+#ifndef NTUPLESCHEMA_HH
+#define NTUPLESCHEMA_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4AutoLock.hh>
+#include <vector>
+
+
+// Columns of the event-level ntuples when they bypass G4AnalysisManager (--async-output, --format gcev).
+// Every thread's AnalysisManager::Book declares them in the same order: the master creates each table
+// and its columns, the workers get the existing id back and their columns are ignored.
+class NtupleSchema {
+public:
+    static constexpr G4int maxColumns = 17;  // the widest ntuple, interactions
+    static constexpr G4int stringSize = 32;  // the one string column a table may have, NUL-terminated
+
+    struct Column {
+        char type;  // I, F, D or S, as in G4AnalysisManager::CreateNtuple<type>Column
+        G4String name;
+    };
+
+    struct Table {
+        G4String name;
+        G4String title;
+        std::vector<Column> columns;
+        G4bool open = true;
+    };
+
+    static NtupleSchema &Instance();
+
+    G4int CreateTable(const G4String &name, const G4String &title);
+    void AddColumn(G4int table, char type, const G4String &name);
+    void FinishTable(G4int table);
+
+    // Copies, for the writers
+    [[nodiscard]] std::vector<Table> Tables() const;
+    [[nodiscard]] Table GetTable(G4int table) const;
+
+private:
+    mutable G4Mutex mutex = G4MUTEX_INITIALIZER;
+    std::vector<Table> tables;
+};
+
+
+union NtupleValue {
+    G4int i;
+    G4float f;
+    G4double d;
+};
+
+// One row: the values in column order and the text of the table's string column
+struct NtupleRecord {
+    G4int table = -1;
+    NtupleValue values[NtupleSchema::maxColumns]{};
+    char str[NtupleSchema::stringSize]{};
+};
+
+#endif //NTUPLESCHEMA_HH
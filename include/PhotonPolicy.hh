@@ -0,0 +1,81 @@
+#ifndef PHOTONPOLICY_HH
+#define PHOTONPOLICY_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4Step.hh>
+#include <G4Track.hh>
+#include <G4StepPoint.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4PhysicalVolumeStore.hh>
+#include <G4NavigationHistory.hh>
+#include <G4SystemOfUnits.hh>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "LightLUT.hh"
+
+
+// What the policy threw away in one event: killed photons (weighted) and the p.e. they were expected
+// to give on each SiPM group, so the bias of a policy run is written next to the npe it biases
+struct PhotonLoss {
+    G4double killed{0};
+    G4double npe[3]{0, 0, 0};  // crystal, veto, bottom veto
+};
+
+// Early termination of optical photons that are unlikely to be detected (--photon-policy). The spec
+// file sets limits per subdetector the photon was born in (Crystal, Veto, BottomVeto, Other):
+//   max_bounces:           300      boundary steps
+//   Crystal.max_path:      10000    track length, mm
+//   Veto.max_time:         500      global time, ns
+//   BottomVeto.min_survival: 1e-4   detection probability of the photon's last scintillator voxel
+// A key without a prefix applies to every subdetector that does not set it, a missing key does not
+// limit, and min_survival spares photons that have not been in a scintillator yet. The survival
+// estimate is the light-collection table summed over channels, so the policy needs a calibrated table;
+// the same estimate, times the photon weight, is what a kill adds to the event's PhotonLoss.
+// The table holds the detection probability of a fresh isotropic photon from the voxel. A photon that has
+// already bounced or travelled far has used up part of that chance, so the loss is an upper bound, and
+// the looser the more a rule kills long-lived photons. PhotonPolicyCheck compares a run with full tracking.
+class PhotonPolicy {
+public:
+    // Empty path: nothing is killed
+    explicit PhotonPolicy(const G4String &path = "");
+
+    [[nodiscard]] G4bool Active() const { return active; }
+
+    // Called on every step of an optical photon; true if the photon was killed
+    G4bool Apply(const G4Step *step, PhotonLoss &loss);
+
+private:
+    struct Limits {
+        G4int maxBounces{-1};
+        G4double maxPath{-1};
+        G4double maxTime{-1};
+        G4double minSurvival{0};
+    };
+
+    static constexpr G4int nOrigins = 4;
+    static constexpr const char *OriginName[nOrigins] = {"Crystal", "Veto", "BottomVeto", "Other"};
+
+    G4bool active{false};
+    Limits limits[nOrigins];
+
+    // Per source scintillator and voxel: detection probability summed over the channels of each group
+    std::shared_ptr<const LightLUT> lut;
+    std::vector<std::array<G4double, 3>> survival[LightLUT::nSources];
+    const G4VPhysicalVolume *sourcePV[LightLUT::nSources]{};
+    G4bool resolved{false};
+
+    // State of the photon being tracked; photons are tracked one at a time
+    G4int origin{nOrigins - 1};
+    G4int bounces{0};
+    std::array<G4double, 3> estimate{0, 0, 0};
+    G4bool estimated{false};  // false until the photon has been in a voxel of the table
+
+    void Resolve();
+    [[nodiscard]] G4int Source(const G4VPhysicalVolume *pv) const;
+};
+
+
+#endif //PHOTONPOLICY_HH
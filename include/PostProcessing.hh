@@ -12,6 +12,12 @@
 #include <set>
 #include <sstream>
 #include <filesystem>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -24,6 +30,9 @@
 #include <TError.h>
 
 #include "Configuration.hh"
+#include "AsyncWriter.hh"
+#include "GcevReader.hh"
+#include "GcevStore.hh"
 
 class TFile;
 class TH1;
@@ -47,12 +56,27 @@ public:
     void SaveOpticsCsv();
 
 private:
+    // One event_summary row (--edep-schema 2)
+    struct EventSummary {
+        Int_t eventID = 0;
+        double E0 = 0.0;
+        double crystal = 0.0;
+        double veto = 0.0;
+        double bottomVeto = 0.0;
+        Int_t trigger = 0;
+    };
+
     std::string outputFolderName;
     double eMinMeV;
     double eMaxMeV;
     std::string particleName;
 
     std::unique_ptr<TFile> rootFile;
+    std::unique_ptr<TFile> asyncFile;  // --async-output: the event-level trees
+    std::unique_ptr<GcevReader> gcevStore;  // --format gcev: the event-level columns
+
+    std::vector<EventSummary> eventSummary;  // --edep-schema 2, see ReadEventSummary
+    bool eventSummaryRead = false;
 
     std::string postProcessingDir;
     std::string runDir;
@@ -67,7 +91,44 @@ private:
     void ExportTreeToCsv(const std::string& treeName,
                          const std::string& csvPath);
 
+    // One row handed out by ScanRows, in the order of the requested names
+    class ScanRow {
+    public:
+        [[nodiscard]] double Real(size_t k) const;
+        [[nodiscard]] Int_t Int(size_t k) const;
+        [[nodiscard]] const char* Text(size_t k) const;
+
+    private:
+        friend class PostProcessing;
+
+        struct Field {
+            char kind = 'I';  // I, F, D: a number of that width; S: a gcev dictionary code; C: a TTree string
+            const char* data = nullptr;  // the mapped gcev column, or slot
+            const std::vector<std::string>* dictionary = nullptr;
+            Long64_t slot = 0;
+            char text[256] = {};
+        };
+
+        std::vector<Field> fields;
+        size_t row = 0;
+    };
+
     TH1* GetHistOrThrow(const std::string& histName);
+    // From the main file, or the AsyncWriter's one with --async-output
+    TTree* GetTree(const std::string& treeName);
+    // Calls fn for every row of the named columns: in place from the mapped gcev columns, else through
+    // GetTree. False when there is no such table or tree; throws on a missing column
+    bool ScanRows(const std::string& treeName,
+                  const std::vector<std::string>& names,
+                  const std::function<void(const ScanRow&)>& fn);
+    // Straight from the mapped columns; false when the store has no such table
+    bool ExportGcevToCsv(const std::string& treeName, const std::string& csvPath);
+    // E_MeV of the leading primary of every event (schema 1)
+    std::unordered_map<int, double> ReadPrimaryE0();
+    // The whole event_summary tree, read in one pass on first use and kept sorted by eventID
+    const std::vector<EventSummary>& ReadEventSummary();
+    // Its row for eventID, nullptr if there is none
+    const EventSummary* FindEventSummary(Int_t eventID);
 
     void SaveHistPng(const std::string& histName,
                      const std::string& outPngPath,
@@ -78,6 +139,7 @@ private:
 
     static double GeomCenter(double eLow, double eHigh);
     static double EffAreaErrFromCounts(double n0, double n, double effArea);
+    static double EffectiveCount(const TH1* h, int bin);
 };
 
 
@@ -0,0 +1,51 @@
+#ifndef PRIMARYBATCH_HH
+#define PRIMARYBATCH_HH
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4ThreeVector.hh>
+#include <G4SystemOfUnits.hh>
+#include <Randomize.hh>
+#include <vector>
+
+#include "Flux/Flux.hh"
+#include "CountRates.hh"
+
+
+// Per-thread buffer of pre-generated primaries (energy, position, direction).
+// Vertices are refilled a whole batch at a time from one block of random numbers, in omp simd loops over
+// structure-of-arrays storage (see the compile options in CMakeLists.txt); GeneratePrimaries only pops records.
+class PrimaryBatch {
+public:
+    PrimaryBatch(size_t capacity, FluxDir direction, const G4ThreeVector &center, G4double radius,
+                 const G4ThreeVector &detectorHalfSize);
+
+    [[nodiscard]] bool Empty() const { return head == Size(); }
+    [[nodiscard]] size_t Size() const { return info.size(); }
+
+    // New vertices for every slot; the energies are left to the caller through Info()
+    void Refill();
+    std::vector<ParticleInfo> &Info() { return info; }
+
+    void Pop(G4ThreeVector &pos, G4ThreeVector &dir, ParticleInfo &particle);
+
+private:
+    FluxDir direction;
+    G4ThreeVector center;
+    G4double radius;
+    G4ThreeVector detectorHalfSize;
+
+    size_t head{0};
+
+    std::vector<G4double> rnd;
+    std::vector<G4double> px, py, pz;
+    std::vector<G4double> dx, dy, dz;
+    std::vector<ParticleInfo> info;
+
+    void FillSphere(G4double cosA, G4double cosB);
+    void FillVertical(G4double z, G4double dirZ);
+    void FillHorizontal();
+};
+
+
+#endif //PRIMARYBATCH_HH
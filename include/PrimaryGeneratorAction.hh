@@ -15,11 +15,16 @@
 #include <G4SystemOfUnits.hh>
 #include <Randomize.hh>
 #include <cmath>
+#include <cfloat>
 #include <fstream>
 #include <numeric>
 #include <utility>
 
 #include "EventAction.hh"
+#include "RunAction.hh"
+#include "StratifiedSampler.hh"
+#include "PrimaryBatch.hh"
+#include "LightCalibration.hh"
 #include "Geometry.hh"
 #include "Flux/Flux.hh"
 #include "Flux/UniformFlux.hh"
@@ -28,16 +33,20 @@
 #include "Flux/SEPFlux.hh"
 #include "Flux/TableFlux.hh"
 #include "Flux/GalacticFlux.hh"
+#include "Flux/CompositeFlux.hh"
 
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
 public:
-    PrimaryGeneratorAction(G4String , const G4String &, G4double cThreshold);
+    PrimaryGeneratorAction(G4String , const G4String &, G4double cThreshold,
+                           const SharedSpectra &spectra = {});
     ~PrimaryGeneratorAction() override;
 
     void GeneratePrimaries(G4Event *evt) override;
 
 private:
+    enum class EnergyBias { None, LogFlat, Stratified };
+
     G4ParticleGun *particleGun = nullptr;
 
     G4double radius;
@@ -45,13 +54,35 @@ private:
     G4ThreeVector detectorHalfSize;
 
     G4String fluxDirection;
+    FluxDir direction{FluxDir::Isotropic};  // fluxDirection, resolved once
+    EnergyBias bias{EnergyBias::None};  // Configuration::energyBias, resolved once
+    G4bool culling{false};              // --ray-culling for an isotropic source
     ParticleInfo pInfo{};
 
     Flux *flux;
+    RunAction *run = nullptr;                 // this thread's RunAction, looked up on the first event
+    EventAction *events = nullptr;            // this thread's EventAction, same
+    StratifiedSampler *stratified = nullptr;
+    PrimaryBatch *batch = nullptr;             // --primary-batch, nullptr when primaries are drawn per event
+    LightCalibration *calibration = nullptr;   // --lut-calibrate, made on the first event once geometry exists
+
+    // Conservative envelope of the geometry used by --ray-culling
+    G4double envRadius;
+    G4double envZMin;
+    G4double envZMax;
+    G4double plateHalfXY;
+    G4double plateZMin;
+    G4double plateZMax;
 
     G4double eCrystalThreshold;
 
     void GenerateOnSphere(G4ThreeVector &pos, G4ThreeVector &dir) const;
+    void SampleParticle(ParticleInfo &info);
+    void DrawPrimary(G4ThreeVector &x, G4ThreeVector &v, ParticleInfo &info);
+    void ShootPrimary(G4Event *evt, const G4ThreeVector &x, const G4ThreeVector &v, const ParticleInfo &info,
+                      G4double t0);
+    void RefillBatch();
+    [[nodiscard]] G4bool HitsEnvelope(const G4ThreeVector &pos, const G4ThreeVector &dir) const;
 };
 
 #endif //PRMIARYGENERATIONACTION_HH
@@ -18,10 +18,23 @@
 #include "Sizes.hh"
 #include "Configuration.hh"
 #include "AnalysisManager.hh"
+#include "InteractionCodes.hh"
+#include "CountRates.hh"
+#include "LightLUT.hh"
 
+// Sums of event weights; plain counts unless the primary energies are biased
 struct ParticleCounts {
-    G4int crystalOnly = 0;
-    G4int crystalAndVeto = 0;
+    G4double crystalOnly = 0;
+    G4double crystalAndVeto = 0;
+};
+
+// Per-species sums of a composite source
+struct SpeciesCounts {
+    G4double generated = 0;
+    G4double crystalOnly = 0;
+    G4double crystalOnlyOpt = 0;
+    std::vector<G4double> effArea;     // per energy bin, from this species' own generated/triggered counts
+    std::vector<G4double> effAreaOpt;
 };
 
 class RunAction : public G4UserRunAction {
@@ -35,29 +48,48 @@ public:
     void BeginOfRunAction(const G4Run *) override;
     void EndOfRunAction(const G4Run *) override;
 
-    void AddCrystalOnly(const G4int v) { crystalOnly += v; }
-    void AddCrystalAndVeto(const G4int v) { crystalAndVeto += v; }
+    void AddCrystalOnly(const G4double w) { crystalOnly += w; }
+    void AddCrystalAndVeto(const G4double w) { crystalAndVeto += w; }
 
-    void AddCrystalOnlyOpt(const G4int v) { crystalOnlyOpt += v; }
-    void AddCrystalAndVetoOpt(const G4int v) { crystalAndVetoOpt += v; }
+    void AddCrystalOnlyOpt(const G4double w) { crystalOnlyOpt += w; }
+    void AddCrystalAndVetoOpt(const G4double w) { crystalAndVetoOpt += w; }
 
-    void AddGenerated(double E_MeV);
-    void AddTriggeredCrystalOnly(double E_MeV);
-    void AddTriggeredCrystalOnlyOpt(double E_MeV);
+    void AddGenerated(double E_MeV, double weight = 1.0, int species = 0);
+    void AddTriggeredCrystalOnly(double E_MeV, double weight = 1.0, int species = 0);
+    void AddTriggeredCrystalOnlyOpt(double E_MeV, double weight = 1.0, int species = 0);
+    // A primary that cannot reach the detector: generated, but never tracked
+    void AddCulled(double E_MeV, double weight = 1.0, int species = 0);
+    // An event stopped by --early-abort once its veto had fired
+    void AddAborted() { aborted += 1.0; }
 
     [[nodiscard]] const ParticleCounts& GetCounts() const { return totals; }
     [[nodiscard]] const ParticleCounts& GetOptCounts() const { return totalsOpt; }
+    [[nodiscard]] G4double GetCulled() const { return totalCulled; }
+    [[nodiscard]] G4double GetAborted() const { return totalAborted; }
+    // One entry per Configuration::fluxComponents, empty for single-species fluxes
+    [[nodiscard]] const std::vector<SpeciesCounts>& GetSpeciesCounts() const { return speciesTotals; }
+
+    // This thread's per-bin sums, not merged yet on workers
+    [[nodiscard]] G4int GetNBins() const { return static_cast<G4int>(genCounts.size()); }
+    [[nodiscard]] G4double GetGenerated(const G4int i) const { return genCounts[i].GetValue(); }
+    [[nodiscard]] G4double GetTriggered(const G4int i) const { return trigCounts[i].GetValue(); }
+    [[nodiscard]] double GetLogEmin() const { return logEmin; }
+    [[nodiscard]] double GetLogEmax() const { return logEmax; }
 
     [[nodiscard]] const std::vector<double>& GetEffArea() const { return effArea; }
     [[nodiscard]] const std::vector<double>& GetEffAreaOpt() const { return effAreaOpt; }
 
 private:
-    G4Accumulable<G4int> crystalOnly{0};   // Crystal && !Veto
-    G4Accumulable<G4int> crystalAndVeto{0};   // Crystal && Veto
-    G4Accumulable<G4int> crystalOnlyOpt{0};
-    G4Accumulable<G4int> crystalAndVetoOpt{0};
+    G4Accumulable<G4double> crystalOnly{0.0};   // Crystal && !Veto
+    G4Accumulable<G4double> crystalAndVeto{0.0};   // Crystal && Veto
+    G4Accumulable<G4double> crystalOnlyOpt{0.0};
+    G4Accumulable<G4double> crystalAndVetoOpt{0.0};
+    G4Accumulable<G4double> culled{0.0};
+    G4Accumulable<G4double> aborted{0.0};
     ParticleCounts totals{};
     ParticleCounts totalsOpt{};
+    G4double totalCulled{0.0};
+    G4double totalAborted{0.0};
 
     double EminMeV{0.0};
     double EmaxMeV{0.0};
@@ -70,6 +102,14 @@ private:
     std::vector<G4Accumulable<G4double>> genCounts;
     std::vector<G4Accumulable<G4double>> trigCounts;
     std::vector<G4Accumulable<G4double>> trigOptCounts;
+    std::vector<G4Accumulable<G4double>> speciesGen;
+    std::vector<G4Accumulable<G4double>> speciesTrig;
+    std::vector<G4Accumulable<G4double>> speciesTrigOpt;
+    // Per species and energy bin, [species * nBins + bin]
+    std::vector<G4Accumulable<G4double>> speciesGenCounts;
+    std::vector<G4Accumulable<G4double>> speciesTrigCounts;
+    std::vector<G4Accumulable<G4double>> speciesTrigOptCounts;
+    std::vector<SpeciesCounts> speciesTotals;
     std::vector<G4double> effArea;
     std::vector<G4double> effAreaOpt;
 
@@ -11,7 +11,7 @@
 #include <G4EventManager.hh>
 #include <G4ParticleDefinition.hh>
 #include <SteppingAction.hh>
-#include <unordered_map>
+#include <vector>
 #include <G4Step.hh>
 #include <G4SDManager.hh>
 #include <G4TouchableHistory.hh>
@@ -21,7 +21,11 @@
 #include <G4ios.hh>
 
 #include "SDHit.hh"
+#include "LightLUTSampler.hh"
 
+// Steps accumulate into a per-thread slot per copy number; a slot belongs to the current event while its
+// generation matches the SD's, so nothing is cleared between events. Hits are made at EndOfEvent, one
+// per touched volume in the order they were first hit.
 class SensitiveDetector : public G4VSensitiveDetector {
 public:
     SensitiveDetector(const G4String &sdName, G4int detID, G4String detName);
@@ -29,6 +33,7 @@ public:
 
     void Initialize(G4HCofThisEvent *hce) override;
     G4bool ProcessHits(G4Step *step, G4TouchableHistory *) override;
+    void EndOfEvent(G4HCofThisEvent *hce) override;
 
     G4int GetHCID() const { return HCID; }
     SDHitCollection *GetHits() { return hits; }
@@ -36,18 +41,29 @@ public:
     const G4String &GetDetName() const { return detName; }
 
 private:
-    SDHit *FindOrCreateHit(G4int volumeID);
+    struct Slot {
+        G4double edep = 0.0;
+        G4double tmin = DBL_MAX;
+        G4int generation = -1;
+    };
+
+    Slot &Touch(G4int volumeID);
 
     SDHitCollection *hits = nullptr;
     SDHitCollection *optHC  = nullptr;
     G4int HCID = -1;
 
-    std::unordered_map<int, int> indexByVol;
+    std::vector<Slot> slots;      // by copy number, grown on first sight of a copy number
+    std::vector<G4int> touched;   // copy numbers hit this event
+    G4int generation = 0;
 
     G4int detID = -1;
     G4String detName;
 
     G4bool isLED = false;
+
+    std::unique_ptr<LightLUTSampler> light;  // --light-lut, made on the first deposit
+    EventAction *events = nullptr;  // this thread's EventAction, looked up on the first veto over threshold
 };
 
 
@@ -3,7 +3,8 @@
 
 #include <G4VSensitiveDetector.hh>
 #include <G4OpBoundaryProcess.hh>
-#include <unordered_map>
+#include <vector>
+#include <cfloat>
 
 #include <G4Step.hh>
 #include <G4Track.hh>
@@ -15,42 +16,75 @@
 
 #include "EventAction.hh"
 #include "AnalysisManager.hh"
+#include "SiPMRegistry.hh"
 
-enum class SiPMGroup { Unknown, Crystal, Veto, Bottom };
+class EventAction;
+
+// Detected photons of one channel and the global time of the first of them.
+// npe is the sum of photon weights and var the sum of their squares, the variance of that sum
+// under photon thinning; both equal the plain count when every weight is 1.
+struct SiPMChannel {
+    double npe{0};
+    double var{0};
+    double tFirst{DBL_MAX};
+
+    // Whether any photon reached the channel this event
+    [[nodiscard]] bool Hit() const { return tFirst < DBL_MAX; }
+};
 
 class SiPMOpticalSD : public G4VSensitiveDetector {
 public:
     explicit SiPMOpticalSD(const G4String& name);
 
-    void SetSiPMWindowLV(G4LogicalVolume* lv) { SiPMWindowLV = lv; }
+    // Detector::GetSiPMRegistry(), which outlives the SD
+    void SetRegistry(const SiPMRegistry* reg) { registry = reg; }
 
     void Initialize(G4HCofThisEvent*) override;
     G4bool ProcessHits(G4Step* step, G4TouchableHistory*) override;
 
     // getters for EventAction
-    int GetNpeCrystal() const { return npeCrystal; }
-    int GetNpeVeto() const { return npeVeto; }
-    int GetNpeBottomVeto() const { return npeBottom; }
+    const SiPMChannel& GetCrystal() const { return crystal; }
+    const SiPMChannel& GetVeto() const { return veto; }
+    const SiPMChannel& GetBottomVeto() const { return bottom; }
 
-    const std::unordered_map<int,int>& GetPerChannelCrystal() const { return perChCrystal; }
-    const std::unordered_map<int,int>& GetPerChannelVeto() const { return perChVeto; }
-    const std::unordered_map<int,int>& GetPerChannelBottom() const { return perChBottom; }
+    // Indexed by channel; channels without a photon this event are not Hit()
+    const std::vector<SiPMChannel>& GetPerChannelCrystal() const { return perChCrystal; }
+    const std::vector<SiPMChannel>& GetPerChannelVeto() const { return perChVeto; }
+    const std::vector<SiPMChannel>& GetPerChannelBottom() const { return perChBottom; }
+
+    // Past its Configuration::npeCap*: the group's remaining photons are not worth tracking
+    [[nodiscard]] G4bool Saturated(SiPMGroup grp) const;
+    // Bit 0 crystal, 1 veto, 2 bottom veto
+    [[nodiscard]] G4int SaturationBits() const;
+
+    // npe unit-weight photons detected on a channel without tracking them (--light-lut)
+    void AddDetected(SiPMGroup grp, int ch, double npe, double t);
 
 private:
     G4OpBoundaryProcess* GetBoundaryProcess();
 
     G4OpBoundaryProcess* boundary{nullptr};
-    G4LogicalVolume* SiPMWindowLV{nullptr};
+    const SiPMRegistry* registry{nullptr};
+    EventAction* events{nullptr};  // this thread's EventAction, looked up on first use
+
+    // Totals per subdetector
+    SiPMChannel crystal;
+    SiPMChannel veto;
+    SiPMChannel bottom;
 
-    int npeCrystal{0};
-    int npeVeto{0};
-    int npeBottom{0};
+    // Sized by Sizes::<group>SiPMCount once the geometry is built
+    std::vector<SiPMChannel> perChCrystal;
+    std::vector<SiPMChannel> perChVeto;
+    std::vector<SiPMChannel> perChBottom;
 
-    std::unordered_map<int,int> perChCrystal;
-    std::unordered_map<int,int> perChVeto;
-    std::unordered_map<int,int> perChBottom;
+    static void Count(SiPMChannel& c, double npe, double var, double t);
+    static void Count(SiPMChannel& total, std::vector<SiPMChannel>& perCh, int ch,
+                      double npe, double var, double t);
 
-    SiPMGroup ClassifyByPVName(const G4VPhysicalVolume* pv);
+    // The registry slot of the SiPM a step is on, checking the pre-step volume first
+    [[nodiscard]] SiPMSlot Lookup(const G4VPhysicalVolume* prePV, const G4VPhysicalVolume* postPV) const;
+    // --early-abort: tells EventAction once a veto's npe is over its threshold
+    void CheckVeto();
 };
 
 #endif // SIPMOPTICALSD_HH
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef SIPMREGISTRY_HH
+#define SIPMREGISTRY_HH
+
+#include <G4VPhysicalVolume.hh>
+#include <unordered_map>
+
+
+enum class SiPMGroup { Unknown, Crystal, Veto, Bottom };
+
+// Subdetector of a SiPM and its channel, the dense copy number 0..<group>SiPMCount-1
+struct SiPMSlot {
+    SiPMGroup group{SiPMGroup::Unknown};
+    int ch{-1};
+};
+
+// Window and body placement of every SiPM, filled by Detector as it places them. The placements
+// are shared by all threads and the map is only read once the geometry is built.
+using SiPMRegistry = std::unordered_map<const G4VPhysicalVolume*, SiPMSlot>;
+
+#endif //SIPMREGISTRY_HH
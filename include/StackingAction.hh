@@ -0,0 +1,58 @@
+#ifndef STACKINGACTION_HH
+#define STACKINGACTION_HH
+
+#include <G4UserStackingAction.hh>
+#include <G4Track.hh>
+#include <G4OpticalPhoton.hh>
+#include <G4EventManager.hh>
+#include <G4PhysicalVolumeStore.hh>
+#include <G4SDManager.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4VProcess.hh>
+#include <G4OpProcessSubType.hh>
+#include <Randomize.hh>
+#include <functional>
+
+#include "EventAction.hh"
+#include "Configuration.hh"
+
+
+enum class PhotonOrigin { Crystal, Veto, BottomVeto, Other };
+
+// Sees every optical photon once, when it is pushed to the stack. Photons are classified by the
+// volume they are born in (a pointer compare against the scintillator PVs) and counted into
+// EventAction::photonCountBuf; the policy then decides whether each one is tracked or killed.
+// With --photon-thinning N every tracked photon carries weight N: scintillation photons are already
+// drawn at 1/N of the yield, the others (Cherenkov) are kept here with probability 1/N. Photons born in
+// a subdetector whose npe has passed its cap (--crystal-npe-cap etc.) are killed here, after counting.
+class StackingAction : public G4UserStackingAction {
+public:
+    using Policy = std::function<G4ClassificationOfNewTrack(const G4Track *, PhotonOrigin)>;
+
+    StackingAction() = default;
+
+    G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track *track) override;
+
+    // Default policy tracks every photon
+    void SetPhotonPolicy(Policy p) { policy = std::move(p); }
+
+private:
+    EventAction *events = nullptr;  // this thread's EventAction, looked up on the first photon
+    SiPMOpticalSD *sipmSD = nullptr;  // for the npe caps
+    const G4VPhysicalVolume *crystalPV = nullptr;
+    const G4VPhysicalVolume *vetoPV = nullptr;
+    const G4VPhysicalVolume *bottomVetoPV = nullptr;
+    G4bool resolved = false;
+    G4double thinning = Configuration::photonThinning;
+    G4bool capped = Configuration::npeCapCrystal > 0 || Configuration::npeCapVeto > 0
+                    || Configuration::npeCapBottomVeto > 0;
+
+    Policy policy;
+
+    void Resolve();
+    [[nodiscard]] PhotonOrigin Origin(const G4Track *track) const;
+    // SiPM group that sees the photons of a subdetector
+    static SiPMGroup Group(PhotonOrigin origin);
+};
+
+#endif //STACKINGACTION_HH
@@ -10,14 +10,39 @@
 #include <G4TouchableHistory.hh>
 #include <G4SystemOfUnits.hh>
 #include <G4UserSteppingAction.hh>
+#include <G4OpticalPhoton.hh>
+#include <G4PhysicalVolumeStore.hh>
+#include <G4SDManager.hh>
 
 #include "EventAction.hh"
+#include "InteractionCodes.hh"
+#include "InteractionFilter.hh"
+#include "PhotonPolicy.hh"
+#include "LightLUT.hh"
+#include "SiPMOpticalSD.hh"
 
 
 class SteppingAction : public G4UserSteppingAction {
 public:
-    SteppingAction() = default;
+    SteppingAction();
     void UserSteppingAction(const G4Step* step) override;
+
+private:
+    InteractionCodes codes;
+    InteractionFilter filter;
+    PhotonPolicy policy;
+
+    // npe caps: photons already stacked when their subdetector saturated die on their first step
+    G4bool capped = Configuration::npeCapCrystal > 0 || Configuration::npeCapVeto > 0
+                    || Configuration::npeCapBottomVeto > 0;
+    G4bool capResolved = false;
+    const G4VPhysicalVolume *scintPV[LightLUT::nSources]{};
+    SiPMOpticalSD *sipmSD = nullptr;
+
+    void ResolveCap();
+    [[nodiscard]] G4bool Saturated(const G4VPhysicalVolume *pv) const;
+    std::vector<G4int> depth;  // generation by track ID, only kept when the filter limits it
+    EventAction* events = nullptr;  // this thread's EventAction, looked up on the first step
 };
 
 #endif //STEPPINGACTION_HH
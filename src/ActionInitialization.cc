@@ -15,6 +15,11 @@ ActionInitialization::ActionInitialization(const G4double a, const G4double Emin
 void ActionInitialization::BuildForMaster() const {
     RunAction* runAct = new RunAction(area, EminMeV, EmaxMeV);
     SetUserAction(runAct);
+
+    const std::unique_ptr<Flux> masterFlux(Flux::Create(fluxType, eCrystalThreshold));
+    if (masterFlux) {
+        spectra = masterFlux->Spectra();
+    }
 }
 
 void ActionInitialization::Build() const {
@@ -24,11 +29,18 @@ void ActionInitialization::Build() const {
     EventAction* eventAct = new EventAction(runAct->analysisManager, runAct);
     SetUserAction(eventAct);
 
-    PrimaryGeneratorAction* primaryGenerator = new PrimaryGeneratorAction(fluxDirection, fluxType, eCrystalThreshold);
+    PrimaryGeneratorAction* primaryGenerator = new PrimaryGeneratorAction(fluxDirection, fluxType, eCrystalThreshold,
+                                                                          spectra);
     SetUserAction(primaryGenerator);
 
-    if (saveSecondaries || savePhotons) {
+    const G4bool npeCap = npeCapCrystal > 0 || npeCapVeto > 0 || npeCapBottomVeto > 0;
+    if (saveSecondaries || !photonPolicy.empty() || npeCap) {
         SteppingAction* stepAct = new SteppingAction();
         SetUserAction(stepAct);
     }
+
+    if (savePhotons || (useOptics && photonThinning > 1) || npeCap) {
+        StackingAction* stackAct = new StackingAction();
+        SetUserAction(stackAct);
+    }
 }
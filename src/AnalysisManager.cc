@@ -1,4 +1,8 @@
 #include "AnalysisManager.hh"
+#include "CountRates.hh"
+
+#include <algorithm>
+#include <cstring>
 
 using namespace Sizes;
 using namespace Configuration;
@@ -15,6 +19,7 @@ AnalysisManager::AnalysisManager(const std::string& fName, const int bins, const
 
 void AnalysisManager::Book() {
     G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+    g4 = analysisManager;
     analysisManager->SetDefaultFileType("root");
     analysisManager->SetFileName(fileName);
     analysisManager->SetVerboseLevel(0);
@@ -23,84 +28,124 @@ void AnalysisManager::Book() {
 #ifdef G4MULTITHREADED
     analysisManager->SetNtupleMerging(true);
 #endif
-    edepNT = analysisManager->CreateNtuple("edep", "energy deposition per sensitive channel");
-    analysisManager->CreateNtupleIColumn("eventID");
-    analysisManager->CreateNtupleSColumn("det_name");
-    analysisManager->CreateNtupleDColumn("edep_MeV");
-    analysisManager->FinishNtuple(edepNT);
-
-    primaryNT = analysisManager->CreateNtuple("primary", "per-primary particles");
-    analysisManager->CreateNtupleIColumn("eventID");
-    analysisManager->CreateNtupleSColumn("primary_name");
-    analysisManager->CreateNtupleDColumn("E_MeV");
-    analysisManager->CreateNtupleDColumn("dir_x");
-    analysisManager->CreateNtupleDColumn("dir_y");
-    analysisManager->CreateNtupleDColumn("dir_z");
-    analysisManager->CreateNtupleDColumn("pos_x_mm");
-    analysisManager->CreateNtupleDColumn("pos_y_mm");
-    analysisManager->CreateNtupleDColumn("pos_z_mm");
-    analysisManager->FinishNtuple(primaryNT);
+    if (edepSchema == 2) {
+        // Event IDs are G4int, so the eventID column needs no more than the I type
+        eventSummaryNT = CreateNtuple("event_summary", "per-event energy deposition and trigger");
+        CreateIColumn("eventID");
+        CreateFColumn("E0_MeV");
+        CreateIColumn("species");
+        CreateFColumn("edep_crystal_MeV");
+        CreateFColumn("edep_veto_MeV");
+        CreateFColumn("edep_bottom_veto_MeV");
+        CreateIColumn("trigger");
+        if (useOptics) {
+            CreateFColumn("npe_crystal");
+            CreateFColumn("npe_veto");
+            CreateFColumn("npe_bottom_veto");
+        }
+        FinishNtuple(eventSummaryNT);
+    } else {
+        edepNT = CreateNtuple("edep", "energy deposition per sensitive channel");
+        CreateIColumn("eventID");
+        CreateSColumn("det_name");
+        CreateDColumn("edep_MeV");
+        CreateDColumn("tmin_ns");
+        FinishNtuple(edepNT);
+    }
+
+    primaryNT = CreateNtuple("primary", "per-primary particles");
+    CreateIColumn("eventID");
+    CreateSColumn("primary_name");
+    CreateDColumn("E_MeV");
+    CreateDColumn("dir_x");
+    CreateDColumn("dir_y");
+    CreateDColumn("dir_z");
+    CreateDColumn("pos_x_mm");
+    CreateDColumn("pos_y_mm");
+    CreateDColumn("pos_z_mm");
+    CreateDColumn("weight");
+    CreateDColumn("t0_ns");
+    CreateIColumn("species");
+    FinishNtuple(primaryNT);
 
     if (saveSecondaries) {
-        interactionsNT = analysisManager->CreateNtuple("interactions",
-                                                       "inelastic/compton/photo/conv vertices and secondaries");
-        analysisManager->CreateNtupleIColumn("eventID");
-        analysisManager->CreateNtupleIColumn("trackID");
-        analysisManager->CreateNtupleIColumn("parentID");
-        analysisManager->CreateNtupleSColumn("process");
-        analysisManager->CreateNtupleSColumn("volume_name");
-        analysisManager->CreateNtupleDColumn("x_mm");
-        analysisManager->CreateNtupleDColumn("y_mm");
-        analysisManager->CreateNtupleDColumn("z_mm");
-        analysisManager->CreateNtupleDColumn("t_ns");
-        analysisManager->CreateNtupleIColumn("sec_index");
-        analysisManager->CreateNtupleSColumn("sec_name");
-        analysisManager->CreateNtupleDColumn("sec_E_MeV");
-        analysisManager->CreateNtupleDColumn("sec_dir_x");
-        analysisManager->CreateNtupleDColumn("sec_dir_y");
-        analysisManager->CreateNtupleDColumn("sec_dir_z");
-        analysisManager->FinishNtuple(interactionsNT);
-
-        eventNT = analysisManager->CreateNtuple("event", "per-event summary");
-        analysisManager->CreateNtupleIColumn("eventID");
-        analysisManager->CreateNtupleIColumn("n_primaries");
-        analysisManager->CreateNtupleIColumn("n_interactions");
-        analysisManager->CreateNtupleIColumn("n_edep_hits");
-        analysisManager->FinishNtuple(eventNT);
+        interactionsNT = CreateNtuple("interactions", "inelastic/compton/photo/conv vertices and secondaries");
+        CreateIColumn("eventID");
+        CreateIColumn("trackID");
+        CreateIColumn("parentID");
+        CreateIColumn("process_code");
+        CreateIColumn("volume_code");
+        CreateIColumn("volume_copy");
+        CreateDColumn("x_mm");
+        CreateDColumn("y_mm");
+        CreateDColumn("z_mm");
+        CreateDColumn("t_ns");
+        CreateIColumn("sec_index");
+        CreateIColumn("sec_pdg");
+        CreateIColumn("sec_code");
+        CreateDColumn("sec_E_MeV");
+        CreateDColumn("sec_dir_x");
+        CreateDColumn("sec_dir_y");
+        CreateDColumn("sec_dir_z");
+        FinishNtuple(interactionsNT);
+
+        // Names of the codes in interactions, written once by the master
+        dictionaryNT = analysisManager->CreateNtuple("dictionary", "process/volume/particle codes");
+        analysisManager->CreateNtupleSColumn("kind");
+        analysisManager->CreateNtupleIColumn("code");
+        analysisManager->CreateNtupleSColumn("name");
+        analysisManager->FinishNtuple(dictionaryNT);
+
+        eventNT = CreateNtuple("event", "per-event summary");
+        CreateIColumn("eventID");
+        CreateIColumn("n_primaries");
+        CreateIColumn("n_interactions");
+        CreateIColumn("n_edep_hits");
+        FinishNtuple(eventNT);
     }
 
     if (useOptics) {
-        SiPMEventNT = analysisManager->CreateNtuple("sipm_event", "SiPM p.e. per event");
-        analysisManager->CreateNtupleIColumn("eventID");
-        analysisManager->CreateNtupleIColumn("npe_crystal");
-        analysisManager->CreateNtupleIColumn("npe_veto");
-        analysisManager->CreateNtupleIColumn("npe_bottom_veto");
-        analysisManager->FinishNtuple(SiPMEventNT);
-
-        SiPMChannelNT = analysisManager->CreateNtuple("sipm_ch", "SiPM p.e. per channel");
-        analysisManager->CreateNtupleIColumn("eventID");
-        analysisManager->CreateNtupleSColumn("subdet");
-        analysisManager->CreateNtupleIColumn("ch");
-        analysisManager->CreateNtupleIColumn("npe");
-        analysisManager->FinishNtuple(SiPMChannelNT);
+        SiPMEventNT = CreateNtuple("sipm_event", "SiPM p.e. per event");
+        CreateIColumn("eventID");
+        CreateDColumn("npe_crystal");
+        CreateDColumn("npe_veto");
+        CreateDColumn("npe_bottom_veto");
+        CreateDColumn("npe_var_crystal");
+        CreateDColumn("npe_var_veto");
+        CreateDColumn("npe_var_bottom_veto");
+        CreateDColumn("npe_lost_crystal");
+        CreateDColumn("npe_lost_veto");
+        CreateDColumn("npe_lost_bottom_veto");
+        CreateDColumn("photons_killed");
+        CreateIColumn("saturated");  // bits: 1 crystal, 2 veto, 4 bottom veto
+        FinishNtuple(SiPMEventNT);
+
+        SiPMChannelNT = CreateNtuple("sipm_ch", "SiPM p.e. per channel");
+        CreateIColumn("eventID");
+        CreateSColumn("subdet");
+        CreateIColumn("ch");
+        CreateDColumn("npe");
+        CreateDColumn("npe_var");
+        CreateDColumn("t_first_ns");
+        FinishNtuple(SiPMChannelNT);
         if (savePhotons) {
-            photonsCountNT = analysisManager->CreateNtuple("photons_count", "generated photon count in volumes");
-            analysisManager->CreateNtupleIColumn("eventID");
-            analysisManager->CreateNtupleIColumn("npe_crystal");
-            analysisManager->CreateNtupleIColumn("npe_veto");
-            analysisManager->CreateNtupleIColumn("npe_bottom_veto");
-            analysisManager->FinishNtuple(photonsCountNT);
-
-            photonsNT = analysisManager->CreateNtuple("photons", "photon register information");
-            analysisManager->CreateNtupleIColumn("eventID");
-            analysisManager->CreateNtupleIColumn("photonID");
-            analysisManager->CreateNtupleSColumn("det_name");
-            analysisManager->CreateNtupleIColumn("det_ch");
-            analysisManager->CreateNtupleDColumn("energy");
-            analysisManager->CreateNtupleDColumn("pos_x");
-            analysisManager->CreateNtupleDColumn("pos_y");
-            analysisManager->CreateNtupleDColumn("pos_z");
-            analysisManager->FinishNtuple(photonsNT);
+            photonsCountNT = CreateNtuple("photons_count", "generated photon count in volumes");
+            CreateIColumn("eventID");
+            CreateDColumn("npe_crystal");
+            CreateDColumn("npe_veto");
+            CreateDColumn("npe_bottom_veto");
+            FinishNtuple(photonsCountNT);
+
+            photonsNT = CreateNtuple("photons", "photon register information");
+            CreateIColumn("eventID");
+            CreateIColumn("photonID");
+            CreateSColumn("det_name");
+            CreateIColumn("det_ch");
+            CreateDColumn("energy");
+            CreateDColumn("pos_x");
+            CreateDColumn("pos_y");
+            CreateDColumn("pos_z");
+            FinishNtuple(photonsNT);
         }
     }
     if (xMin < xMax) {
@@ -119,7 +164,9 @@ void AnalysisManager::Book() {
                                                       "N_{trig,opt} vs E",
                                                       nBins, xMin, xMax, unit, "none", logScheme);
 
-        if (fluxDirection.find("isotropic") != std::string::npos) {
+        FluxDir dir = FluxDir::Isotropic;
+        fluxDirFromName(fluxDirection, dir);
+        if (isIsotropic(dir)) {
             sensitivityHist = analysisManager->CreateH1("sensitivityHist",
                                                         "Sensitivity vs E",
                                                         nBins, xMin, xMax, unit, "none", logScheme);
@@ -141,115 +188,225 @@ void AnalysisManager::Book() {
     }
 }
 
+G4int AnalysisManager::CreateNtuple(const G4String& name, const G4String& title) {
+    if (ownNtuples) return booking = NtupleSchema::Instance().CreateTable(name, title);
+    return g4->CreateNtuple(name, title);
+}
+
+void AnalysisManager::CreateColumn(const char type, const G4String& name) {
+    if (ownNtuples) {
+        NtupleSchema::Instance().AddColumn(booking, type, name);
+        return;
+    }
+    if (type == 'I') g4->CreateNtupleIColumn(name);
+    else if (type == 'F') g4->CreateNtupleFColumn(name);
+    else if (type == 'D') g4->CreateNtupleDColumn(name);
+    else if (type == 'S') g4->CreateNtupleSColumn(name);
+}
+
+void AnalysisManager::FinishNtuple(const G4int nt) {
+    if (ownNtuples) NtupleSchema::Instance().FinishTable(nt);
+    else g4->FinishNtuple(nt);
+}
+
+void AnalysisManager::FillI(const G4int nt, const G4int col, const G4int v) {
+    if (ownNtuples) row.values[col].i = v;
+    else g4->FillNtupleIColumn(nt, col, v);
+}
+
+void AnalysisManager::FillF(const G4int nt, const G4int col, const G4float v) {
+    if (ownNtuples) row.values[col].f = v;
+    else g4->FillNtupleFColumn(nt, col, v);
+}
+
+void AnalysisManager::FillD(const G4int nt, const G4int col, const G4double v) {
+    if (ownNtuples) row.values[col].d = v;
+    else g4->FillNtupleDColumn(nt, col, v);
+}
+
+void AnalysisManager::FillS(const G4int nt, const G4int col, const G4String& v) {
+    if (ownNtuples) {
+        const size_t n = std::min(v.size(), static_cast<size_t>(NtupleSchema::stringSize - 1));
+        std::memcpy(row.str, v.data(), n);
+        row.str[n] = '\0';
+    } else {
+        g4->FillNtupleSColumn(nt, col, v);
+    }
+}
+
+void AnalysisManager::AddRow(const G4int nt) {
+    if (gcev) {
+        row.table = nt;
+        gcev->Append(row);
+    } else if (asyncOutput) {
+        row.table = nt;
+        AsyncWriter::Instance().Push(row);
+    } else {
+        g4->AddNtupleRow(nt);
+    }
+}
+
 void AnalysisManager::Open() {
     G4AnalysisManager::Instance()->OpenFile(fileName);
+    // The workers have not started yet
+    if (asyncOutput && G4Threading::IsMasterThread()) {
+        AsyncWriter::Instance().Start(AsyncWriter::PathFor(fileName), G4RunManager::GetRunManager()->GetNumberOfThreads(),
+                                      static_cast<size_t>(asyncBufferMB) << 20);
+    }
+    if (gcevOutput) {
+        const G4String dir = GcevStore::DirFor(fileName);
+        if (G4Threading::IsMasterThread()) GcevStore::Begin(dir);
+        gcev = std::make_unique<GcevWriter>(dir, G4Threading::G4GetThreadId() + 1);
+    }
 }
 
 void AnalysisManager::Close() {
     G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
     analysisManager->Write();
     analysisManager->CloseFile();
+    // The master closes after every worker has finished its events
+    if (asyncOutput && G4Threading::IsMasterThread()) AsyncWriter::Instance().Stop();
+    if (gcev) {
+        gcev->Close();
+        gcev.reset();
+        if (G4Threading::IsMasterThread()) GcevStore::WriteIndex(GcevStore::DirFor(fileName));
+    }
 }
 
 void AnalysisManager::FillEventRow(G4int eventID, G4int nPrimaries, G4int nInteractions, G4int nEdepHits) {
-    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(eventNT, 0, eventID);
-    analysisManager->FillNtupleIColumn(eventNT, 1, nPrimaries);
-    analysisManager->FillNtupleIColumn(eventNT, 2, nInteractions);
-    analysisManager->FillNtupleIColumn(eventNT, 3, nEdepHits);
-    analysisManager->AddNtupleRow(eventNT);
+    FillI(eventNT, 0, eventID);
+    FillI(eventNT, 1, nPrimaries);
+    FillI(eventNT, 2, nInteractions);
+    FillI(eventNT, 3, nEdepHits);
+    AddRow(eventNT);
 }
 
 void AnalysisManager::FillPrimaryRow(G4int eventID, const G4String& primaryName,
                                      G4double E_MeV, const G4ThreeVector& dir,
-                                     const G4ThreeVector& pos_mm) {
-    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(primaryNT, 0, eventID);
-    analysisManager->FillNtupleSColumn(primaryNT, 1, primaryName);
-    analysisManager->FillNtupleDColumn(primaryNT, 2, E_MeV);
-    analysisManager->FillNtupleDColumn(primaryNT, 3, dir.x());
-    analysisManager->FillNtupleDColumn(primaryNT, 4, dir.y());
-    analysisManager->FillNtupleDColumn(primaryNT, 5, dir.z());
-    analysisManager->FillNtupleDColumn(primaryNT, 6, pos_mm.x());
-    analysisManager->FillNtupleDColumn(primaryNT, 7, pos_mm.y());
-    analysisManager->FillNtupleDColumn(primaryNT, 8, pos_mm.z());
-    analysisManager->AddNtupleRow(primaryNT);
+                                     const G4ThreeVector& pos_mm, const G4double weight,
+                                     const G4double t0_ns, const G4int species) {
+    FillI(primaryNT, 0, eventID);
+    FillS(primaryNT, 1, primaryName);
+    FillD(primaryNT, 2, E_MeV);
+    FillD(primaryNT, 3, dir.x());
+    FillD(primaryNT, 4, dir.y());
+    FillD(primaryNT, 5, dir.z());
+    FillD(primaryNT, 6, pos_mm.x());
+    FillD(primaryNT, 7, pos_mm.y());
+    FillD(primaryNT, 8, pos_mm.z());
+    FillD(primaryNT, 9, weight);
+    FillD(primaryNT, 10, t0_ns);
+    FillI(primaryNT, 11, species);
+    AddRow(primaryNT);
 }
 
-void AnalysisManager::FillInteractionRow(G4int eventID,
-                                         G4int trackID, G4int parentID,
-                                         const G4String& process,
-                                         const G4String& volumeName,
-                                         const G4ThreeVector& x_mm,
-                                         G4int secIndex, const G4String& secName,
-                                         G4double secE_MeV, const G4ThreeVector& secDir) {
-    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(interactionsNT, 0, eventID);
-    analysisManager->FillNtupleIColumn(interactionsNT, 1, trackID);
-    analysisManager->FillNtupleIColumn(interactionsNT, 2, parentID);
-    analysisManager->FillNtupleSColumn(interactionsNT, 3, process);
-    analysisManager->FillNtupleSColumn(interactionsNT, 4, volumeName);
-    analysisManager->FillNtupleDColumn(interactionsNT, 5, x_mm.x());
-    analysisManager->FillNtupleDColumn(interactionsNT, 6, x_mm.y());
-    analysisManager->FillNtupleDColumn(interactionsNT, 7, x_mm.z());
-    analysisManager->FillNtupleIColumn(interactionsNT, 8, secIndex);
-    analysisManager->FillNtupleSColumn(interactionsNT, 9, secName);
-    analysisManager->FillNtupleDColumn(interactionsNT, 10, secE_MeV);
-    analysisManager->FillNtupleDColumn(interactionsNT, 11, secDir.x());
-    analysisManager->FillNtupleDColumn(interactionsNT, 12, secDir.y());
-    analysisManager->FillNtupleDColumn(interactionsNT, 13, secDir.z());
-    analysisManager->AddNtupleRow(interactionsNT);
+void AnalysisManager::FillInteractionRows(G4int eventID, const InteractionBuffer& buf) {
+    for (size_t i = 0; i < buf.size(); ++i) {
+        FillI(interactionsNT, 0, eventID);
+        FillI(interactionsNT, 1, buf.trackID[i]);
+        FillI(interactionsNT, 2, buf.parentID[i]);
+        FillI(interactionsNT, 3, buf.processCode[i]);
+        FillI(interactionsNT, 4, buf.volumeCode[i]);
+        FillI(interactionsNT, 5, buf.volumeCopy[i]);
+        FillD(interactionsNT, 6, buf.x_mm[i]);
+        FillD(interactionsNT, 7, buf.y_mm[i]);
+        FillD(interactionsNT, 8, buf.z_mm[i]);
+        FillD(interactionsNT, 9, buf.t_ns[i]);
+        FillI(interactionsNT, 10, buf.secIndex[i]);
+        FillI(interactionsNT, 11, buf.secPDG[i]);
+        FillI(interactionsNT, 12, buf.secCode[i]);
+        FillD(interactionsNT, 13, buf.secE_MeV[i]);
+        FillD(interactionsNT, 14, buf.secDirX[i]);
+        FillD(interactionsNT, 15, buf.secDirY[i]);
+        FillD(interactionsNT, 16, buf.secDirZ[i]);
+        AddRow(interactionsNT);
+    }
 }
 
-void AnalysisManager::FillEdepRow(G4int eventID, const G4String& det_name, G4double edep_MeV) {
+void AnalysisManager::FillDictionaryRow(const G4String& kind, G4int code, const G4String& name) {
     G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(edepNT, 0, eventID);
-    analysisManager->FillNtupleSColumn(edepNT, 1, det_name);
-    analysisManager->FillNtupleDColumn(edepNT, 2, edep_MeV);
-    analysisManager->AddNtupleRow(edepNT);
+    analysisManager->FillNtupleSColumn(dictionaryNT, 0, kind);
+    analysisManager->FillNtupleIColumn(dictionaryNT, 1, code);
+    analysisManager->FillNtupleSColumn(dictionaryNT, 2, name);
+    analysisManager->AddNtupleRow(dictionaryNT);
 }
 
-void AnalysisManager::FillSiPMEventRow(int eventID, int npeC, int npeV, int npeBV) {
-    auto* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(SiPMEventNT, 0, eventID);
-    analysisManager->FillNtupleIColumn(SiPMEventNT, 1, npeC);
-    analysisManager->FillNtupleIColumn(SiPMEventNT, 2, npeV);
-    analysisManager->FillNtupleIColumn(SiPMEventNT, 3, npeBV);
-    analysisManager->AddNtupleRow(SiPMEventNT);
+void AnalysisManager::FillEdepRow(G4int eventID, const G4String& det_name, G4double edep_MeV, G4double tmin_ns) {
+    FillI(edepNT, 0, eventID);
+    FillS(edepNT, 1, det_name);
+    FillD(edepNT, 2, edep_MeV);
+    FillD(edepNT, 3, tmin_ns);
+    AddRow(edepNT);
 }
 
-void AnalysisManager::FillSiPMChannelRow(int eventID, const G4String& subdet, int ch, int npe) {
-    auto* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(SiPMChannelNT, 0, eventID);
-    analysisManager->FillNtupleSColumn(SiPMChannelNT, 1, subdet);
-    analysisManager->FillNtupleIColumn(SiPMChannelNT, 2, ch);
-    analysisManager->FillNtupleIColumn(SiPMChannelNT, 3, npe);
-    analysisManager->AddNtupleRow(SiPMChannelNT);
+void AnalysisManager::FillEventSummaryRow(G4int eventID, G4double E0_MeV, G4int species,
+                                          G4double edepC, G4double edepV, G4double edepB, G4int trigger,
+                                          G4double npeC, G4double npeV, G4double npeB) {
+    FillI(eventSummaryNT, 0, eventID);
+    FillF(eventSummaryNT, 1, static_cast<G4float>(E0_MeV));
+    FillI(eventSummaryNT, 2, species);
+    FillF(eventSummaryNT, 3, static_cast<G4float>(edepC));
+    FillF(eventSummaryNT, 4, static_cast<G4float>(edepV));
+    FillF(eventSummaryNT, 5, static_cast<G4float>(edepB));
+    FillI(eventSummaryNT, 6, trigger);
+    if (useOptics) {
+        FillF(eventSummaryNT, 7, static_cast<G4float>(npeC));
+        FillF(eventSummaryNT, 8, static_cast<G4float>(npeV));
+        FillF(eventSummaryNT, 9, static_cast<G4float>(npeB));
+    }
+    AddRow(eventSummaryNT);
+}
+
+void AnalysisManager::FillSiPMEventRow(int eventID, double npeC, double npeV, double npeBV,
+                                       double varC, double varV, double varBV,
+                                       double lostC, double lostV, double lostBV, double killed, int saturated) {
+    FillI(SiPMEventNT, 0, eventID);
+    FillD(SiPMEventNT, 1, npeC);
+    FillD(SiPMEventNT, 2, npeV);
+    FillD(SiPMEventNT, 3, npeBV);
+    FillD(SiPMEventNT, 4, varC);
+    FillD(SiPMEventNT, 5, varV);
+    FillD(SiPMEventNT, 6, varBV);
+    FillD(SiPMEventNT, 7, lostC);
+    FillD(SiPMEventNT, 8, lostV);
+    FillD(SiPMEventNT, 9, lostBV);
+    FillD(SiPMEventNT, 10, killed);
+    FillI(SiPMEventNT, 11, saturated);
+    AddRow(SiPMEventNT);
+}
+
+void AnalysisManager::FillSiPMChannelRow(int eventID, const G4String& subdet, int ch, double npe, double var,
+                                         double tFirst_ns) {
+    FillI(SiPMChannelNT, 0, eventID);
+    FillS(SiPMChannelNT, 1, subdet);
+    FillI(SiPMChannelNT, 2, ch);
+    FillD(SiPMChannelNT, 3, npe);
+    FillD(SiPMChannelNT, 4, var);
+    FillD(SiPMChannelNT, 5, tFirst_ns);
+    AddRow(SiPMChannelNT);
 }
 
 void AnalysisManager::FillPhotonCountRow(G4int eventID,
-                                         G4int npeCrystal, G4int npeVeto,
-                                         G4int npeBottomVeto) {
-    G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(photonsCountNT, 0, eventID);
-    analysisManager->FillNtupleIColumn(photonsCountNT, 1, npeCrystal);
-    analysisManager->FillNtupleIColumn(photonsCountNT, 2, npeVeto);
-    analysisManager->FillNtupleIColumn(photonsCountNT, 3, npeBottomVeto);
-    analysisManager->AddNtupleRow(photonsCountNT);
+                                         G4double npeCrystal, G4double npeVeto,
+                                         G4double npeBottomVeto) {
+    FillI(photonsCountNT, 0, eventID);
+    FillD(photonsCountNT, 1, npeCrystal);
+    FillD(photonsCountNT, 2, npeVeto);
+    FillD(photonsCountNT, 3, npeBottomVeto);
+    AddRow(photonsCountNT);
 }
 
 void AnalysisManager::FillPhotonRow(G4int eventID, G4int photonID, const G4String& det_name, G4int det_ch,
                                     G4double energy_eV, G4double x_mm, G4double y_mm, G4double z_mm) {
-    auto* analysisManager = G4AnalysisManager::Instance();
-    analysisManager->FillNtupleIColumn(photonsNT, 0, eventID);
-    analysisManager->FillNtupleIColumn(photonsNT, 1, photonID);
-    analysisManager->FillNtupleSColumn(photonsNT, 2, det_name);
-    analysisManager->FillNtupleIColumn(photonsNT, 3, det_ch);
-    analysisManager->FillNtupleDColumn(photonsNT, 4, energy_eV);
-    analysisManager->FillNtupleDColumn(photonsNT, 5, x_mm);
-    analysisManager->FillNtupleDColumn(photonsNT, 6, y_mm);
-    analysisManager->FillNtupleDColumn(photonsNT, 7, z_mm);
-    analysisManager->AddNtupleRow(photonsNT);
+    FillI(photonsNT, 0, eventID);
+    FillI(photonsNT, 1, photonID);
+    FillS(photonsNT, 2, det_name);
+    FillI(photonsNT, 3, det_ch);
+    FillD(photonsNT, 4, energy_eV);
+    FillD(photonsNT, 5, x_mm);
+    FillD(photonsNT, 6, y_mm);
+    FillD(photonsNT, 7, z_mm);
+    AddRow(photonsNT);
 }
 
 
@@ -0,0 +1,135 @@
+#include "AsyncWriter.hh"
+
+#include <G4Exception.hh>
+#include <G4Threading.hh>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <TFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+
+AsyncWriter &AsyncWriter::Instance() {
+    static AsyncWriter instance;
+    return instance;
+}
+
+
+G4String AsyncWriter::PathFor(const G4String &outputFile) {
+    G4String stem = outputFile;
+    if (stem.size() > 5 && stem.compare(stem.size() - 5, 5, ".root") == 0) stem.erase(stem.size() - 5);
+    return stem + "_rows.root";
+}
+
+
+bool AsyncWriter::Ring::TryPush(const Record &record) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+    slots[t & mask] = record;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+
+bool AsyncWriter::Ring::TryPop(Record &record) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    record = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+
+void AsyncWriter::Start(const G4String &path, const G4int nThreads, const size_t budgetBytes) {
+    if (running) Stop();
+
+    // Only the writer thread touches ROOT while the run is going, PostProcessing only after Stop
+    ROOT::EnableThreadSafety();
+
+    const size_t nRings = static_cast<size_t>(std::max(nThreads, 1)) + 1;
+    size_t capacity = 256;
+    while (capacity * 2 * nRings * sizeof(Record) <= budgetBytes) capacity *= 2;
+
+    rings.clear();
+    for (size_t i = 0; i < nRings; ++i) rings.push_back(std::make_unique<Ring>(capacity));
+
+    stopping.store(false);
+    running = true;
+    writer = std::thread(&AsyncWriter::Drain, this, path);
+}
+
+
+void AsyncWriter::Stop() {
+    if (!running) return;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+    rings.clear();
+    running = false;
+}
+
+
+void AsyncWriter::Push(const Record &record) {
+    const size_t slot = static_cast<size_t>(G4Threading::G4GetThreadId() + 1);
+    if (slot >= rings.size()) {
+        G4Exception("AsyncWriter::Push", "AsyncOutput", FatalException,
+                    "no output ring for this thread: the writer was not started for this many threads");
+    }
+    Ring &ring = *rings[slot];
+    while (!ring.TryPush(record)) std::this_thread::yield();
+}
+
+
+void AsyncWriter::Drain(const G4String &path) {
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "RECREATE"));
+    if (!file || file->IsZombie()) {
+        G4Exception("AsyncWriter::Drain", "AsyncOutput", FatalException, ("cannot open " + path).c_str());
+        return;
+    }
+
+    // Branches read from one staging row per table
+    const std::vector<NtupleSchema::Table> tables = NtupleSchema::Instance().Tables();
+    std::vector<TTree *> trees(tables.size());
+    std::vector<std::vector<NtupleValue>> stage(tables.size());
+    std::vector<std::vector<char>> strings(tables.size());
+    std::vector<G4bool> hasString(tables.size(), false);
+    for (size_t t = 0; t < tables.size(); ++t) {
+        const NtupleSchema::Table &table = tables[t];
+        trees[t] = new TTree(table.name.c_str(), table.title.c_str());
+        stage[t].resize(table.columns.size());
+        strings[t].assign(NtupleSchema::stringSize, '\0');
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            const NtupleSchema::Column &col = table.columns[c];
+            if (col.type == 'S') {
+                trees[t]->Branch(col.name.c_str(), strings[t].data(), (col.name + "/C").c_str());
+                hasString[t] = true;
+            } else {
+                trees[t]->Branch(col.name.c_str(), &stage[t][c], (col.name + "/" + col.type).c_str());
+            }
+        }
+    }
+
+    const auto fill = [&](const Record &record) {
+        const size_t t = static_cast<size_t>(record.table);
+        std::copy_n(record.values, stage[t].size(), stage[t].begin());
+        if (hasString[t]) std::memcpy(strings[t].data(), record.str, NtupleSchema::stringSize);
+        trees[t]->Fill();
+    };
+
+    // A pass that starts after Stop sees every record, since the producers are done by then
+    constexpr size_t batch = 4096;  // per ring and pass, so that one busy thread cannot starve the others
+    Record record;
+    while (true) {
+        const G4bool last = stopping.load(std::memory_order_acquire);
+        size_t n = 0;
+        for (auto &ring: rings) {
+            for (size_t k = 0; (last || k < batch) && ring->TryPop(record); ++k, ++n) fill(record);
+        }
+        if (last) break;
+        if (n == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    file->Write();
+    file->Close();
+}
@@ -1,4 +1,5 @@
 #include "CountRates.hh"
+#include "Flux/SpectrumFile.hh"
 
 
 double fluxPLAW(const double E, const double A, double const alpha, const double E_piv) {
@@ -9,8 +10,14 @@ double fluxCOMP(const double E, const double A, const double alpha, const double
     return A * std::pow(E / E_piv, -alpha) * std::exp((alpha - 2.0) * (E / E_peak));
 }
 
-// SEP: read CSV
-static std::vector<double> readSepRow(int year, int order, const std::string& csvPath) {
+// SEP: coefficients from the precompiled SEP_<year>_<order>.gcspec, else from CSV
+std::vector<double> readSepRow(const int year, const int order, const std::string& csvPath) {
+    const auto file = SpectrumFile::Open(
+        SpectrumFile::PathFor(csvPath, "SEP_" + std::to_string(year) + "_" + std::to_string(order)), {csvPath});
+    if (file && file->AuxSize() > 0) {
+        return {file->Aux(), file->Aux() + file->AuxSize()};
+    }
+
     std::ifstream in(csvPath);
     if (!in.is_open()) {
         throw std::runtime_error("SEP: cannot open coefficients CSV: " + csvPath);
@@ -71,6 +78,15 @@ double fluxTable(const double E, const std::string& csvPath) {
     static std::vector<double> cached_energies;
     static std::vector<double> cached_fluxes;
 
+    if (csvPath != cached_path || cached_energies.empty()) {
+        if (const auto file = SpectrumFile::Open(SpectrumFile::PathFor(csvPath), {csvPath});
+            file && file->RawSize() > 0) {
+            cached_energies.assign(file->RawE(), file->RawE() + file->RawSize());
+            cached_fluxes.assign(file->RawFlux(), file->RawFlux() + file->RawSize());
+            cached_path = csvPath;
+        }
+    }
+
     if (csvPath != cached_path || cached_energies.empty()) {
         std::ifstream in(csvPath);
         if (!in.is_open()) {
@@ -240,6 +256,21 @@ double fluxGalactic(const double E, const double phiMV, const std::string& name)
 
 // ---------------- Area ----------------
 
+bool fluxDirFromName(const std::string& name, FluxDir& dir) {
+    static const std::pair<const char*, FluxDir> names[] = {
+        {"isotropic", FluxDir::Isotropic}, {"isotropic_up", FluxDir::Isotropic_up},
+        {"isotropic_down", FluxDir::Isotropic_down}, {"vertical_up", FluxDir::Vertical_up},
+        {"vertical_down", FluxDir::Vertical_down}, {"horizontal", FluxDir::Horizontal}
+    };
+    for (const auto& [n, d] : names) {
+        if (name == n) {
+            dir = d;
+            return true;
+        }
+    }
+    return false;
+}
+
 double Area_cm2(const double R_mm, const double H_mm, const FluxDir dir) {
     const double R_cm = R_mm / 10.0;
     const double H_cm = H_mm / 10.0;
@@ -299,7 +330,7 @@ RateResult computeRate(const FluxType type,
                        const FluxParams& p,
                        EnergyRange eRange,
                        double A_eff_cm2,
-                       const int N_histories,
+                       const double N_histories,
                        const RateCounts& detCounts) {
     std::function<double(double)> f;
 
@@ -349,9 +380,9 @@ RateResult computeRate(const FluxType type,
     R.area = A_eff_cm2;
     R.integral = integral;
     R.Ndot = Ndot;
-    R.rateCrystal = N_histories > 0 ? (detCounts.crystalOnly + 0.0) * Ndot / N_histories : 0.0;
-    const int bothDet = detCounts.crystalOnly + detCounts.crystalAndVeto;
-    R.rateBoth = N_histories > 0 ? (bothDet + 0.0) * Ndot / N_histories : 0.0;
+    R.rateCrystal = N_histories > 0 ? detCounts.crystalOnly * Ndot / N_histories : 0.0;
+    const double bothDet = detCounts.crystalOnly + detCounts.crystalAndVeto;
+    R.rateBoth = N_histories > 0 ? bothDet * Ndot / N_histories : 0.0;
     return R;
 }
 
@@ -431,3 +462,115 @@ RateResult computeRateReal(FluxType type,
     R.rateRealCrystal = rateReal;
     return R;
 }
+
+
+// ---------------- Composite ----------------
+
+static std::string trimmed(const std::string& s) {
+    const size_t start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    const size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+static std::string readParam(const std::string& path, const std::string& key) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Composite: cannot open flux config " + path);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t pos = line.find(':');
+        if (pos == std::string::npos) continue;
+        if (trimmed(line.substr(0, pos)) == key) return trimmed(line.substr(pos + 1));
+    }
+    throw std::runtime_error("Composite: no '" + key + "' in " + path);
+}
+
+FluxComponent readFluxComponent(const std::string& spec, const std::string& configDir) {
+    FluxComponent c;
+    c.spec = trimmed(spec);
+
+    const size_t colon = c.spec.find(':');
+    const std::string type = c.spec.substr(0, colon);
+    const std::string particle = colon == std::string::npos ? "" : trimmed(c.spec.substr(colon + 1));
+    const std::string path = configDir + type + "_params.txt";
+
+    if (type == "PLAW") {
+        c.type = FluxType::PLAW;
+        c.params.A = std::stod(readParam(path, "A"));
+        c.params.alpha = std::stod(readParam(path, "alpha"));
+        c.params.E_piv = std::stod(readParam(path, "E_Piv"));
+    } else if (type == "COMP") {
+        c.type = FluxType::COMP;
+        c.params.A = std::stod(readParam(path, "A"));
+        c.params.alpha = std::stod(readParam(path, "alpha"));
+        c.params.E_piv = std::stod(readParam(path, "E_Piv"));
+        c.params.E_peak = std::stod(readParam(path, "E_Peak"));
+    } else if (type == "SEP") {
+        c.type = FluxType::SEP;
+        c.params.sep_year = std::stoi(readParam(path, "year"));
+        c.params.sep_order = std::stoi(readParam(path, "order"));
+        c.params.sep_csv_path = "../SEP_coefficients.CSV";
+    } else if (type == "Galactic") {
+        c.type = FluxType::GALACTIC;
+        c.params.phiMV = std::stod(readParam(path, "phiMV"));
+        c.params.particle = particle.empty() ? readParam(path, "particle") : particle;
+    } else if (type == "Table") {
+        c.type = FluxType::TABLE;
+        c.params.table_path = readParam(path, "table_path");
+        c.params.particle = readParam(path, "particle");
+    } else {
+        throw std::runtime_error("Composite: unsupported component " + c.spec);
+    }
+    c.eRange.Emin = std::stod(readParam(path, "E_min"));
+    c.eRange.Emax = std::stod(readParam(path, "E_max"));
+    return c;
+}
+
+double componentIntegral(const FluxComponent& c) {
+    return computeRate(c.type, c.params, c.eRange, 1.0, 0.0, RateCounts{}).Ndot;
+}
+
+RateResult computeRateComposite(const std::vector<FluxComponent>& components,
+                                const double A_eff_cm2,
+                                const double N_histories,
+                                const RateCounts& detCounts) {
+    if (components.empty()) throw std::runtime_error("computeRateComposite: no components");
+
+    double integral = 0.0;
+    for (const auto& c : components) integral += componentIntegral(c);
+    const double Ndot = A_eff_cm2 * integral;
+
+    RateResult R;
+    R.area = A_eff_cm2;
+    R.integral = integral;
+    R.Ndot = Ndot;
+    R.rateCrystal = N_histories > 0 ? detCounts.crystalOnly * Ndot / N_histories : 0.0;
+    const double bothDet = detCounts.crystalOnly + detCounts.crystalAndVeto;
+    R.rateBoth = N_histories > 0 ? bothDet * Ndot / N_histories : 0.0;
+    return R;
+}
+
+RateResult computeRateRealComposite(const std::vector<FluxComponent>& components,
+                                    const EnergyRange eRange,
+                                    const std::vector<std::vector<double>>& Aeff,
+                                    const int nBins) {
+    if (components.empty()) throw std::runtime_error("computeRateRealComposite: no components");
+    if (Aeff.size() != components.size())
+        throw std::runtime_error("computeRateRealComposite: Aeff.size() != components.size()");
+
+    RateResult R;
+    std::vector<double> masked;
+    for (size_t k = 0; k < components.size(); ++k) {
+        const auto& c = components[k];
+        masked.assign(Aeff[k].size(), 0.0);
+        for (int i = 0; i < static_cast<int>(masked.size()); ++i) {
+            const double Ec = std::sqrt(binEdgeLog(eRange.Emin, eRange.Emax, nBins, i) *
+                                        binEdgeLog(eRange.Emin, eRange.Emax, nBins, i + 1));
+            masked[i] = Ec >= c.eRange.Emin && Ec <= c.eRange.Emax ? Aeff[k][i] : 0.0;
+        }
+        R.rateRealCrystal += computeRateReal(c.type, c.params, eRange, masked, nBins).rateRealCrystal;
+    }
+    return R;
+}
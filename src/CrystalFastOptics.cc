@@ -0,0 +1,41 @@
+#include "CrystalFastOptics.hh"
+
+
+CrystalFastOptics::CrystalFastOptics(const G4String &name, G4Region *region)
+    : G4VFastSimulationModel(name, region), light(0) {}
+
+
+G4bool CrystalFastOptics::IsApplicable(const G4ParticleDefinition &particle) {
+    return &particle == G4Electron::Definition();
+}
+
+
+G4double CrystalFastOptics::Range(const G4Track *track) {
+    return G4LossTableManager::Instance()->GetRange(G4Electron::Definition(), track->GetKineticEnergy(),
+                                                    track->GetMaterialCutsCouple());
+}
+
+
+// Contained: the CSDA range fits inside the safety to the crystal surface
+G4bool CrystalFastOptics::ModelTrigger(const G4FastTrack &fastTrack) {
+    const G4Track *track = fastTrack.GetPrimaryTrack();
+    if (track->GetKineticEnergy() <= 0.0) return false;
+    const G4double safety = fastTrack.GetEnvelopeSolid()->DistanceToOut(fastTrack.GetPrimaryTrackLocalPosition());
+    return Range(track) < safety;
+}
+
+
+void CrystalFastOptics::DoIt(const G4FastTrack &fastTrack, G4FastStep &fastStep) {
+    const G4Track *track = fastTrack.GetPrimaryTrack();
+    const G4double ekin = track->GetKineticEnergy();
+    const G4double range = Range(track);
+    const G4Material *mat = track->GetMaterial();
+
+    fastStep.KillPrimaryTrack();
+    fastStep.ProposePrimaryTrackPathLength(0.0);
+    fastStep.ProposeTotalEnergyDeposited(ekin);
+
+    const G4double kB = mat->GetIonisation()->GetBirksConstant();
+    const G4double visible = kB > 0.0 && range > 0.0 ? ekin / (1.0 + kB * ekin / range) : ekin;
+    light.Deposit(mat, visible, fastTrack.GetPrimaryTrackLocalPosition(), track->GetGlobalTime());
+}
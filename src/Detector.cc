@@ -58,10 +58,18 @@ void Detector::DefineMaterials() {
         return Utils::ReadConstFile(base + prefix + "_optical_consts.txt");
     };
 
-    auto applyYieldScaleIfPresent = [&](Utils::ConstMap& c) {
+    // Photon thinning: scintillation draws 1/N of the photons and each carries weight N (set in
+    // StackingAction). The resolution scale shrinks by sqrt(N) so that N times the drawn count keeps
+    // the intrinsic width of the unthinned yield.
+    auto applyPhotonThinning = [&](Utils::ConstMap& c) {
+        if (photonThinning <= 1) return;
         auto it = c.find("SCINTILLATIONYIELD");
-        if (it != c.end() && yieldScale > 0) {
-            it->second /= static_cast<G4double>(yieldScale);
+        if (it != c.end()) {
+            it->second /= photonThinning;
+        }
+        it = c.find("RESOLUTIONSCALE");
+        if (it != c.end()) {
+            it->second /= std::sqrt(photonThinning);
         }
     };
 
@@ -105,7 +113,7 @@ void Detector::DefineMaterials() {
 
         // --- Load scint consts
         auto c = loadConsts(matPrefix);
-        applyYieldScaleIfPresent(c);
+        applyPhotonThinning(c);
 
         // --- Build MPT
         auto* mpt = new G4MaterialPropertiesTable();
@@ -128,7 +136,7 @@ void Detector::DefineMaterials() {
         auto emission = loadEmission2(p);
 
         auto c = loadConsts(p);
-        applyYieldScaleIfPresent(c);
+        applyPhotonThinning(c);
 
         auto* mpt = new G4MaterialPropertiesTable();
         mpt->AddProperty("RINDEX", rindex.E, rindex.V, rindex.E.size());
@@ -815,6 +823,7 @@ void Detector::ConstructCrystalSiPM() {
 
             new G4LogicalBorderSurface("CrystalSiPM_Photocathode_" + std::to_string(copyN), windowPVP, bodyPVP,
                                        SiPMPhotocathodeSurf);
+            RegisterSiPM(windowPVP, bodyPVP, SiPMGroup::Crystal, copyN);
             copyN++;
         }
     }
@@ -838,6 +847,7 @@ void Detector::ConstructCrystalSiPM() {
 
             new G4LogicalBorderSurface("CrystalSiPM_Photocathode_" + std::to_string(i), windowPVP, bodyPVP,
                                        SiPMPhotocathodeSurf);
+            RegisterSiPM(windowPVP, bodyPVP, SiPMGroup::Crystal, static_cast<int>(copyN + i));
         }
         copyN += crystalEdgeSiPMCount;
     };
@@ -939,6 +949,7 @@ void Detector::ConstructVetoSiPM() {
 
         new G4LogicalBorderSurface("VetoSiPM_Photocathode_" + std::to_string(i),
                                    windowPVP, bodyPVP, SiPMPhotocathodeSurf);
+        RegisterSiPM(windowPVP, bodyPVP, SiPMGroup::Veto, static_cast<int>(i));
     }
 }
 
@@ -978,9 +989,16 @@ void Detector::ConstructBottomVetoSiPM() {
 
         new G4LogicalBorderSurface("BottomVetoSiPM_Photocathode_" + std::to_string(i),
                                    windowPVP, bodyPVP, SiPMPhotocathodeSurf);
+        RegisterSiPM(windowPVP, bodyPVP, SiPMGroup::Bottom, static_cast<int>(i));
     }
 }
 
+void Detector::RegisterSiPM(const G4VPhysicalVolume* windowPVP, const G4VPhysicalVolume* bodyPVP,
+                            const SiPMGroup group, const int ch) {
+    sipmRegistry[windowPVP] = {group, ch};
+    sipmRegistry[bodyPVP] = {group, ch};
+}
+
 std::vector<G4LogicalVolume*> Detector::GetSensitiveLV() const {
     return {
         crystalLV,
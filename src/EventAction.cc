@@ -18,19 +18,37 @@ void EventAction::BeginOfEventAction(const G4Event*) {
     nEdepHits = 0;
     hasCrystal = false;
     hasVeto = false;
+    vetoEdepFired = false;
+    vetoNpeFired = false;
+    abortRequested = false;
+    for (int k = 0; k < 3; ++k) edepSum[k] = npeSum[k] = 0.0;
+}
+
+void EventAction::VetoFired(const G4bool optical) {
+    (optical ? vetoNpeFired : vetoEdepFired) = true;
+    if (abortRequested || !vetoEdepFired || (useOptics && !vetoNpeFired)) return;
+    abortRequested = true;
+    G4EventManager::GetEventManager()->AbortCurrentEvent();
 }
 
 void EventAction::EndOfEventAction(const G4Event* evt) {
     const int eventID = evt->GetEventID();
 
+    // An aborted event keeps what was tracked before its veto fired: crystalOnly is already ruled out
+    if (run && evt->IsAborted()) run->AddAborted();
+
     WritePrimaries_(eventID);
     nPrimaries = static_cast<int>(primBuf.size());
 
     double primaryE_MeV = -1.0;
+    double weight = 1.0;
+    int species = 0;
     if (!primBuf.empty()) {
         primaryE_MeV = primBuf.front().E_MeV;
+        weight = primBuf.front().weight;
+        species = primBuf.front().species;
         if (run) {
-            run->AddGenerated(primaryE_MeV);
+            run->AddGenerated(primaryE_MeV, weight, species);
         }
     }
     primBuf.clear();
@@ -52,43 +70,44 @@ void EventAction::EndOfEventAction(const G4Event* evt) {
         analysisManager->FillEventRow(eventID, nPrimaries, nInteractions, nEdepHits);
     }
 
-    if (run and hasCrystal && !hasVeto) run->AddCrystalOnly(1);
-    if (run and hasCrystal && hasVeto) run->AddCrystalAndVeto(1);
+    if (run and hasCrystal && !hasVeto) run->AddCrystalOnly(weight);
+    if (run and hasCrystal && hasVeto) run->AddCrystalAndVeto(weight);
 
     if (primaryE_MeV > 0.0) {
         if (hasCrystal && !hasVeto) {
             if (run) {
-                run->AddTriggeredCrystalOnly(primaryE_MeV);
+                run->AddTriggeredCrystalOnly(primaryE_MeV, weight, species);
             }
         }
     }
 
     if (useOptics) {
         WriteSiPMFromSD_(eventID);
-        if (run and hasCrystalOpt && !hasVetoOpt) run->AddCrystalOnlyOpt(1);
-        if (run and hasCrystalOpt && hasVetoOpt) run->AddCrystalAndVetoOpt(1);
+        if (lutCalibrate && sipmSD && lutEmission.emitted > 0) {
+            LightLUT::Tally(lutEmission.source, lutEmission.voxel, lutEmission.emitted, *sipmSD);
+        }
+        lutEmission = {};
+        photonLoss = {};
+        if (run and hasCrystalOpt && !hasVetoOpt) run->AddCrystalOnlyOpt(weight);
+        if (run and hasCrystalOpt && hasVetoOpt) run->AddCrystalAndVetoOpt(weight);
 
         if (primaryE_MeV > 0.0) {
-            if (run and hasCrystalOpt && !hasVetoOpt) run->AddTriggeredCrystalOnlyOpt(primaryE_MeV);
+            if (run and hasCrystalOpt && !hasVetoOpt) run->AddTriggeredCrystalOnlyOpt(primaryE_MeV, weight, species);
         }
     }
+
+    if (edepSchema == 2) WriteEventSummary_(eventID, primaryE_MeV, species);
 }
 
 void EventAction::WritePrimaries_(int eventID) {
     for (const auto& p : primBuf) {
-        analysisManager->FillPrimaryRow(eventID, p.name, p.E_MeV, p.dir, p.pos_mm);
+        analysisManager->FillPrimaryRow(eventID, p.def->GetParticleName(), p.E_MeV, p.dir, p.pos_mm, p.weight, p.t0_ns, p.species);
     }
 }
 
 int EventAction::WriteInteractions_(int eventID) {
     if (saveSecondaries) {
-        for (const auto& r : interBuf) {
-            analysisManager->FillInteractionRow(eventID,
-                                                r.trackID, r.parentID,
-                                                r.process, r.volumeName, r.pos_mm,
-                                                r.secIndex, r.secName,
-                                                r.secE_MeV, r.secDir);
-        }
+        analysisManager->FillInteractionRows(eventID, interBuf);
     }
     return static_cast<int>(interBuf.size());
 }
@@ -146,7 +165,8 @@ int EventAction::WriteEdepFromSD_(const G4Event* evt, int eventID) {
             if (edep_MeV > 0.0) {
                 if (det_name == "Crystal") MarkCrystal();
                 else if (det_name == "Veto" or det_name == "BottomVeto") MarkVeto();
-                analysisManager->FillEdepRow(eventID, det_name, edep_MeV);
+                if (edepSchema == 2) edepSum[std::get<1>(detMap[i])] += edep_MeV;
+                else analysisManager->FillEdepRow(eventID, det_name, edep_MeV, h->tmin / ns);
             }
         }
         nHitsTotal += static_cast<int>(N);
@@ -156,41 +176,62 @@ int EventAction::WriteEdepFromSD_(const G4Event* evt, int eventID) {
 }
 
 void EventAction::WriteSiPMFromSD_(int eventID) {
-    auto* sdm = G4SDManager::GetSDMpointer();
-    if (!sdm) return;
+    if (!sipmSD) {
+        auto* sdm = G4SDManager::GetSDMpointer();
+        if (!sdm) return;
+        sipmSD = dynamic_cast<SiPMOpticalSD*>(sdm->FindSensitiveDetector("SiPMOpticalSD", false));
+        if (!sipmSD) return;
+    }
 
-    auto* sdBase = sdm->FindSensitiveDetector("SiPMOpticalSD", false);
-    auto* sipmSD = dynamic_cast<SiPMOpticalSD*>(sdBase);
-    if (!sipmSD) return;
+    const G4int saturated = sipmSD->SaturationBits();
 
-    int npeC = sipmSD->GetNpeCrystal();
-    int npeV = sipmSD->GetNpeVeto();
-    int npeB = sipmSD->GetNpeBottomVeto();
+    // Thresholds apply to the reconstructed (weighted) p.e. count
+    SiPMChannel c = sipmSD->GetCrystal();
+    SiPMChannel v = sipmSD->GetVeto();
+    SiPMChannel b = sipmSD->GetBottomVeto();
 
-    npeC = npeC > oCrystalThreshold ? npeC : 0;
-    npeV = npeV > oVetoThreshold ? npeV : 0;
-    npeB = npeB > oBottomVetoThreshold ? npeB : 0;
+    if (c.npe <= oCrystalThreshold) c = SiPMChannel{};
+    if (v.npe <= oVetoThreshold) v = SiPMChannel{};
+    if (b.npe <= oBottomVetoThreshold) b = SiPMChannel{};
 
-    if (npeC > 0) MarkCrystalOpt();
-    if (npeV > 0 or npeB > 0) MarkVetoOpt();
+    if (c.npe > 0) MarkCrystalOpt();
+    if (v.npe > 0 or b.npe > 0) MarkVetoOpt();
+    npeSum[0] = c.npe;
+    npeSum[1] = v.npe;
+    npeSum[2] = b.npe;
 
-    analysisManager->FillSiPMEventRow(eventID, npeC, npeV, npeB);
+    // Lost p.e. are reported before thresholds: they are the bias of the policy, not a signal
+    analysisManager->FillSiPMEventRow(eventID, c.npe, v.npe, b.npe, c.var, v.var, b.var,
+                                      photonLoss.npe[0], photonLoss.npe[1], photonLoss.npe[2], photonLoss.killed,
+                                      saturated);
 
-    for (const auto& kv : sipmSD->GetPerChannelCrystal()) {
-        const int ch = kv.first;
-        const int npe = kv.second;
-        analysisManager->FillSiPMChannelRow(eventID, "Crystal", ch, npe);
+    const auto& perCrystal = sipmSD->GetPerChannelCrystal();
+    for (int ch = 0; ch < static_cast<int>(perCrystal.size()); ++ch) {
+        const SiPMChannel& sc = perCrystal[ch];
+        if (sc.Hit()) analysisManager->FillSiPMChannelRow(eventID, "Crystal", ch, sc.npe, sc.var, sc.tFirst / ns);
     }
 
-    for (const auto& kv : sipmSD->GetPerChannelVeto()) {
-        const int ch = kv.first;
-        const int npe = kv.second;
-        analysisManager->FillSiPMChannelRow(eventID, "Veto", ch, npe);
+    const auto& perVeto = sipmSD->GetPerChannelVeto();
+    for (int ch = 0; ch < static_cast<int>(perVeto.size()); ++ch) {
+        const SiPMChannel& sc = perVeto[ch];
+        if (sc.Hit()) analysisManager->FillSiPMChannelRow(eventID, "Veto", ch, sc.npe, sc.var, sc.tFirst / ns);
     }
 
-    for (const auto& kv : sipmSD->GetPerChannelBottom()) {
-        const int ch = kv.first;
-        const int npe = kv.second;
-        analysisManager->FillSiPMChannelRow(eventID, "BottomVeto", ch, npe);
+    const auto& perBottom = sipmSD->GetPerChannelBottom();
+    for (int ch = 0; ch < static_cast<int>(perBottom.size()); ++ch) {
+        const SiPMChannel& sc = perBottom[ch];
+        if (sc.Hit()) analysisManager->FillSiPMChannelRow(eventID, "BottomVeto", ch, sc.npe, sc.var, sc.tFirst / ns);
     }
 }
+
+void EventAction::WriteEventSummary_(int eventID, double primaryE_MeV, int species) {
+    // Same classification as the edep and sipm_event rows of schema 1, after thresholds
+    int trigger = 0;
+    if (hasCrystal) trigger |= 1;
+    if (hasVeto) trigger |= 2;
+    if (npeSum[0] > 0) trigger |= 4;
+    if (npeSum[1] > 0 or npeSum[2] > 0) trigger |= 8;
+
+    analysisManager->FillEventSummaryRow(eventID, primaryE_MeV, species, edepSum[0], edepSum[1], edepSum[2],
+                                         trigger, npeSum[0], npeSum[1], npeSum[2]);
+}
@@ -1,6 +1,6 @@
 #include "Flux/COMPFlux.hh"
 
-COMPFlux::COMPFlux(const G4double cThreshold) {
+COMPFlux::COMPFlux(const G4double cThreshold, std::shared_ptr<const Spectrum> shared) {
     particle = "gamma";
 
     configFile = "../Flux_config/COMP_params.txt";
@@ -10,7 +10,12 @@ COMPFlux::COMPFlux(const G4double cThreshold) {
     Emin = std::max({GetParam(configFile, "E_min", 0.01) * MeV, cThreshold});
     Emax = GetParam(configFile, "E_max", 50.) * MeV;
 
+    if (shared) {
+        UseSpectrum(std::move(shared));
+        return;
+    }
     BuildCDF();
+    UseSpectrum(std::make_shared<const Spectrum>(energyGrid, cdfGrid, Emin, Emax));
 }
 
 void COMPFlux::BuildCDF() {
@@ -61,18 +66,5 @@ void COMPFlux::BuildCDF() {
 
 
 double COMPFlux::SampleEnergy() {
-    double u = G4UniformRand();
-
-    const auto it = std::lower_bound(cdfGrid.begin(), cdfGrid.end(), u);
-    if (it == cdfGrid.begin()) return energyGrid.front();
-    if (it == cdfGrid.end()) return energyGrid.back();
-
-    const int idx = std::distance(cdfGrid.begin(), it);
-    const double u1 = cdfGrid[idx - 1];
-    const double u2 = cdfGrid[idx];
-    const double E1 = energyGrid[idx - 1];
-    double E2 = energyGrid[idx];
-
-    const double t = (u - u1) / (u2 - u1);
-    return E1 + t * (E2 - E1);
+    return spectrum->Sample();
 }
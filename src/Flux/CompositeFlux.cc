@@ -0,0 +1,84 @@
+#include "Flux/CompositeFlux.hh"
+#include "Flux/GalacticFlux.hh"
+
+#include <sstream>
+
+
+CompositeFlux::CompositeFlux(const G4double cThreshold, const SharedSpectra &shared) {
+    configFile = "../Flux_config/Composite_params.txt";
+    Emin = std::max({GetParam(configFile, "E_min", 1.) * MeV, cThreshold});
+    Emax = GetParam(configFile, "E_max", 1000000.) * MeV;
+
+    const G4String line = GetParam(configFile, "components", "");
+    std::stringstream ss(line);
+    G4String spec;
+    while (std::getline(ss, spec, ',')) {
+        spec = Trim(spec);
+        if (spec.empty()) continue;
+
+        FluxComponent c;
+        try {
+            c = readFluxComponent(spec);
+        } catch (const std::exception &e) {
+            G4Exception("CompositeFlux::CompositeFlux", "BAD_CONFIG", FatalException, e.what());
+        }
+        // Same lower edge as the component samples from
+        c.eRange.Emin = std::max(c.eRange.Emin, cThreshold / MeV);
+        fractions.push_back(componentIntegral(c));
+
+        const G4String type = spec.substr(0, spec.find(':'));
+        const size_t k = components.size();
+        std::shared_ptr<const Spectrum> own = k < shared.size() ? shared[k] : nullptr;
+        if (type == "Galactic") {
+            components.emplace_back(new GalacticFlux(cThreshold, std::move(own), c.params.particle));
+        } else {
+            components.emplace_back(Create(type, cThreshold, {std::move(own)}));
+        }
+    }
+
+    if (components.empty()) {
+        G4Exception("CompositeFlux::CompositeFlux", "BAD_CONFIG", FatalException,
+                    ("No components in " + configFile).c_str());
+    }
+    const G4double sum = std::accumulate(fractions.begin(), fractions.end(), 0.0);
+    if (!(sum > 0.0) || !std::isfinite(sum)) {
+        G4Exception("CompositeFlux::CompositeFlux", "BAD_INTEGRAL", FatalException,
+                    "Integrated flux of the components is non-positive or non-finite.");
+    }
+    for (auto &f: fractions) f /= sum;
+    table = AliasTable(fractions);
+}
+
+
+SharedSpectra CompositeFlux::Spectra() const {
+    SharedSpectra out;
+    for (const auto &c: components) out.push_back(c->GetSpectrum());
+    return out;
+}
+
+
+ParticleInfo CompositeFlux::GenerateParticle() {
+    const size_t i = table.Sample(G4UniformRand());
+    ParticleInfo info = components[i]->GenerateParticle();
+    info.species = static_cast<G4int>(i);
+    return info;
+}
+
+
+ParticleInfo CompositeFlux::GenerateSpecies() {
+    const size_t i = table.Sample(G4UniformRand());
+    ParticleInfo info = components[i]->GenerateSpecies();
+    info.species = static_cast<G4int>(i);
+    return info;
+}
+
+
+void CompositeFlux::SetEnergyBias(const G4String &bias) {
+    Flux::SetEnergyBias(bias);
+    for (auto &c: components) c->SetEnergyBias(bias);
+}
+
+
+G4double CompositeFlux::SampleEnergy() {
+    return GenerateParticle().energy;
+}
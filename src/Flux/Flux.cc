@@ -1,16 +1,68 @@
 #include "Flux/Flux.hh"
+#include "Flux/UniformFlux.hh"
+#include "Flux/PLAWFlux.hh"
+#include "Flux/COMPFlux.hh"
+#include "Flux/SEPFlux.hh"
+#include "Flux/TableFlux.hh"
+#include "Flux/GalacticFlux.hh"
+#include "Flux/CompositeFlux.hh"
+
+
+Flux *Flux::Create(const G4String &type, const G4double cThreshold, const SharedSpectra &shared) {
+    std::shared_ptr<const Spectrum> one = shared.empty() ? nullptr : shared.front();
+    if (type == "Uniform") return new UniformFlux(cThreshold);
+    if (type == "PLAW") return new PLAWFlux(cThreshold);
+    if (type == "COMP") return new COMPFlux(cThreshold, std::move(one));
+    if (type == "SEP") return new SEPFlux(cThreshold, std::move(one));
+    if (type == "Galactic") return new GalacticFlux(cThreshold, std::move(one));
+    if (type == "Table") return new TableFlux(cThreshold, std::move(one));
+    if (type == "Composite") return new CompositeFlux(cThreshold, shared);
+    return nullptr;
+}
 
 ParticleInfo Flux::GenerateParticle() {
-    auto *pt = G4ParticleTable::GetParticleTable();
+    ParticleInfo info;
+    info.weight = 1.0;
+    info.energy = logFlat ? SampleLogFlat(info.weight) : SampleEnergy();
+    info.def = Definition();
+    info.pdg = info.def->GetPDGEncoding();
+    return info;
+}
 
+ParticleInfo Flux::GenerateSpecies() {
     ParticleInfo info;
-    info.energy = SampleEnergy();
-    info.def = pt->FindParticle(particle);
-    info.name = particle;
+    info.energy = 0.0;
+    info.def = Definition();
     info.pdg = info.def->GetPDGEncoding();
     return info;
 }
 
+G4ParticleDefinition *Flux::Definition() {
+    if (!definition) definition = FindDefinition(particle);
+    return definition;
+}
+
+G4ParticleDefinition *Flux::FindDefinition(const G4String &name) {
+    auto *def = G4ParticleTable::GetParticleTable()->FindParticle(name);
+    if (!def) {
+        G4Exception("Flux::FindDefinition", "UNKNOWN_PARTICLE", FatalException,
+                    ("Particle not found: " + name).c_str());
+    }
+    return def;
+}
+
+G4double Flux::SampleLogFlat(G4double &weight) {
+    weight = 1.0;
+    if (!spectrum || spectrum->Empty()) return SampleEnergy();
+    return spectrum->SampleLogFlat(weight) * spectrumUnit;
+}
+
+void Flux::UseSpectrum(std::shared_ptr<const Spectrum> s) {
+    spectrum = std::move(s);
+    Emin = spectrum->Emin();
+    Emax = spectrum->Emax();
+}
+
 G4String Flux::Trim(const G4String &_s) {
     const size_t start = _s.find_first_not_of(" \t\r\n");
     if (start == G4String::npos) return "";
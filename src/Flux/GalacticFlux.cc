@@ -1,15 +1,25 @@
 #include "Flux/GalacticFlux.hh"
 
-GalacticFlux::GalacticFlux(const G4double cThreshold) {
+GalacticFlux::GalacticFlux(const G4double cThreshold, std::shared_ptr<const Spectrum> shared,
+                           const G4String &particleName) {
 
     configFile = "../Flux_config/Galactic_params.txt";
-    particle = GetParam(configFile, "particle", "proton");
+    particle = particleName.empty() ? GetParam(configFile, "particle", "proton") : particleName;
     phiMV = GetParam(configFile, "phiMV", 600);
 
     Emin = std::max({GetParam(configFile, "E_min", 1.) * MeV, cThreshold});
     Emax = GetParam(configFile, "E_max", 1000000.) * MeV;
+    spectrumUnit = GeV;
 
+    if (shared) {
+        UseSpectrum(std::move(shared));
+        return;
+    }
+    // The grid spans the configured range; the alpha flux rescales Emin/Emax while it is evaluated
+    const G4double lo = Emin;
+    const G4double hi = Emax;
     BuildCDF();
+    UseSpectrum(std::make_shared<const Spectrum>(energyGrid, cdfGrid, lo, hi));
 }
 
 
@@ -155,16 +165,5 @@ G4double GalacticFlux::J_TOA_GeV(const G4double E) {
 }
 
 G4double GalacticFlux::SampleEnergy() {
-    const G4double u = G4UniformRand(); // равномерное [0,1)
-
-    const auto it = std::lower_bound(cdfGrid.begin(), cdfGrid.end(), u);
-    const int idx = std::max(1, static_cast<int>(it - cdfGrid.begin()));
-
-    const G4double u1 = cdfGrid[idx - 1];
-    const G4double u2 = cdfGrid[idx];
-    const G4double E1 = energyGrid[idx - 1];
-    const G4double E2 = energyGrid[idx];
-
-    const G4double t = (u - u1) / (u2 - u1);
-    return (E1 + t * (E2 - E1)) * GeV;
+    return spectrum->Sample() * spectrumUnit;
 }
@@ -22,3 +22,17 @@ double PLAWFlux::SampleEnergy() {
     double val = EminPow + u * (EmaxPow - EminPow);
     return std::pow(val, 1.0 / (1.0 - alpha));
 }
+
+
+double PLAWFlux::SampleLogFlat(G4double &weight) {
+    const double span = std::log(Emax / Emin);
+    const double E = Emin * std::exp(G4UniformRand() * span);
+
+    double pdfLnE = 1.0 / span;
+    if (std::abs(alpha - 1.0) >= 1e-12) {
+        pdfLnE = (1.0 - alpha) * std::pow(E, 1.0 - alpha) /
+                 (std::pow(Emax, 1.0 - alpha) - std::pow(Emin, 1.0 - alpha));
+    }
+    weight = pdfLnE * span;
+    return E;
+}
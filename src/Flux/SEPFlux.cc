@@ -1,8 +1,9 @@
 #include "Flux/SEPFlux.hh"
 
 
-SEPFlux::SEPFlux(const G4double cThreshold) {
+SEPFlux::SEPFlux(const G4double cThreshold, std::shared_ptr<const Spectrum> shared) {
     path = "../SEP_spectrum.CSV";
+    coeffPath = "../SEP_coefficients.CSV";
     particle = "proton";
 
     configFile = "../Flux_config/SEP_params.txt";
@@ -12,7 +13,47 @@ SEPFlux::SEPFlux(const G4double cThreshold) {
     Emin = std::max({GetParam(configFile, "E_min", 0.1) * MeV, cThreshold});
     Emax = GetParam(configFile, "E_max", 1000.) * MeV;
 
-    BuildCDF();
+    if (shared) {
+        UseSpectrum(std::move(shared));
+        return;
+    }
+
+    // One .gcspec per year/order holds the matching spectrum rows and the fit coefficients for CountRates
+    const SpectrumFile::Key key{Emin, Emax, year, order};
+    const std::string binPath = SpectrumFile::PathFor(path, "SEP_" + std::to_string(year) + "_" +
+                                                            std::to_string(order));
+    const auto file = SpectrumFile::Open(binPath, {path, coeffPath});
+    if (file && file->GetKey() == key) {
+        UseSpectrum(file->MakeSpectrum());
+        return;
+    }
+
+    std::vector<Row> rows;
+    if (file) {
+        rows.reserve(file->RawSize());
+        for (size_t i = 0; i < file->RawSize(); ++i) rows.push_back({file->RawE()[i], file->RawFlux()[i]});
+    } else {
+        rows = ReadRows();
+    }
+
+    BuildCDF(rows);
+    UseSpectrum(std::make_shared<const Spectrum>(EList, CDF, Emin, Emax));
+
+    if (!file && rows.size() >= 2) {
+        std::vector<G4double> rawE, rawFlux, coeffs;
+        rawE.reserve(rows.size());
+        rawFlux.reserve(rows.size());
+        for (const auto &[E, flux]: rows) {
+            rawE.push_back(E);
+            rawFlux.push_back(flux);
+        }
+        try {
+            coeffs = readSepRow(year, order, coeffPath);
+        } catch (const std::exception &) {
+            coeffs.clear();
+        }
+        SpectrumFile::Write(binPath, key, rawE, rawFlux, *spectrum, coeffs);
+    }
 }
 
 
@@ -26,20 +67,16 @@ static std::vector<double> ExtractNumbers(const std::string &line) {
 }
 
 
-void SEPFlux::BuildCDF() {
-    EList.clear();
-    CDF.clear();
+std::vector<Row> SEPFlux::ReadRows() const {
+    std::vector<Row> rows;
 
     std::ifstream in(path.c_str());
     if (!in) {
-        G4Exception("SEPFlux::BuildCDF", "CSV_OPEN_FAIL",
+        G4Exception("SEPFlux::ReadRows", "CSV_OPEN_FAIL",
                     JustWarning, ("Cannot open " + path).c_str());
-        EList = {1. * MeV, 10. * MeV};
-        CDF = {0.0, 1.0};
-        return;
+        return rows;
     }
 
-    std::vector<Row> rows;
     rows.reserve(1884);
 
     std::string line;
@@ -63,6 +100,13 @@ void SEPFlux::BuildCDF() {
         }
     }
     in.close();
+    return rows;
+}
+
+
+void SEPFlux::BuildCDF(std::vector<Row> rows) {
+    EList.clear();
+    CDF.clear();
 
     if (rows.size() < 2) {
         G4Exception("PrimaryGeneratorAction::BuildCSVFluxCDF", "CSV_NO_ROWS",
@@ -173,23 +217,6 @@ void SEPFlux::BuildCDF() {
 }
 
 G4double SEPFlux::SampleEnergy() {
-    if (EList.size() < 2) return 1.0 * MeV;
-
-    const G4double u = G4UniformRand();
-
-    const auto it = std::upper_bound(CDF.begin(), CDF.end(), u);
-    if (it == CDF.begin()) return EList.front();
-    if (it == CDF.end()) return EList.back();
-    const size_t j = std::distance(CDF.begin(), it);
-    const size_t i = j - 1;
-
-    const double C0 = CDF[i];
-    const double C1 = CDF[j];
-    const double t = (u - C0) / std::max(C1 - C0, 1e-12);
-
-    const double lnE0 = std::log(EList[i]);
-    const double lnE1 = std::log(EList[j]);
-    const double lnEu = lnE0 + t * (lnE1 - lnE0);
-
-    return std::exp(lnEu);
+    if (spectrum->Empty()) return 1.0 * MeV;
+    return spectrum->Sample();
 }
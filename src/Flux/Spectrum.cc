@@ -0,0 +1,84 @@
+#include "Flux/Spectrum.hh"
+
+
+AliasTable::AliasTable(const std::vector<G4double> &weights) {
+    n = weights.size();
+    probStore.assign(n, 1.0);
+    aliasStore.resize(n);
+    for (size_t i = 0; i < n; ++i) aliasStore[i] = static_cast<G4int>(i);
+    prob = probStore.data();
+    alias = aliasStore.data();
+    if (n == 0) return;
+
+    long double sum = 0.0L;
+    for (const auto w: weights) {
+        if (w > 0.0 && std::isfinite(w)) sum += w;
+    }
+    if (sum <= 0.0L) return;
+
+    // Scaled so that the mean is 1: entries below 1 borrow the rest of their column from an entry above 1
+    std::vector<G4double> scaled(n);
+    std::vector<size_t> small, large;
+    small.reserve(n);
+    large.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const G4double w = weights[i] > 0.0 && std::isfinite(weights[i]) ? weights[i] : 0.0;
+        scaled[i] = static_cast<G4double>(w * static_cast<long double>(n) / sum);
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const size_t s = small.back();
+        small.pop_back();
+        const size_t l = large.back();
+
+        probStore[s] = scaled[s];
+        aliasStore[s] = static_cast<G4int>(l);
+
+        scaled[l] = scaled[l] + scaled[s] - 1.0;
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Leftovers are 1 up to rounding
+    for (const auto i: large) probStore[i] = 1.0;
+    for (const auto i: small) probStore[i] = 1.0;
+}
+
+
+Spectrum::Spectrum(const std::vector<G4double> &E, const std::vector<G4double> &cdf_, const G4double Emin,
+                   const G4double Emax) : eMin(Emin), eMax(Emax) {
+    const size_t N = std::min(E.size(), cdf_.size());
+    if (N < 2) return;
+
+    logEStore.resize(N);
+    for (size_t i = 0; i < N; ++i) logEStore[i] = std::log(E[i]);
+    cdfStore.assign(cdf_.begin(), cdf_.begin() + static_cast<std::ptrdiff_t>(N));
+
+    std::vector<G4double> binProb(N - 1);
+    for (size_t i = 0; i + 1 < N; ++i) {
+        binProb[i] = std::max(0.0, cdfStore[i + 1] - cdfStore[i]);
+    }
+    table = AliasTable(binProb);
+
+    logE = logEStore.data();
+    cdf = cdfStore.data();
+    n = N;
+}
+
+
+G4double Spectrum::DensityLnE(const G4double lnE) const {
+    if (n < 2 || lnE < logE[0] || lnE > logE[n - 1]) return 0.0;
+    const size_t j = static_cast<size_t>(std::upper_bound(logE, logE + n, lnE) - logE);
+    const size_t i = std::min(j > 0 ? j - 1 : 0, n - 2);
+    const G4double dl = logE[i + 1] - logE[i];
+    return dl > 0.0 ? std::max(0.0, cdf[i + 1] - cdf[i]) / dl : 0.0;
+}
+
+
+Spectrum::Spectrum(std::shared_ptr<const void> storage_, const G4double *logE_, const G4double *cdf_,
+                   const size_t n_, const G4double *prob, const G4int *alias, const G4double Emin,
+                   const G4double Emax)
+    : storage(std::move(storage_)), logE(logE_), cdf(cdf_), n(n_), eMin(Emin), eMax(Emax),
+      table(prob, alias, n_ > 0 ? n_ - 1 : 0) {}
@@ -0,0 +1,171 @@
+#include "Flux/SpectrumFile.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    constexpr char Magic[8] = {'G', 'C', 'S', 'P', 'E', 'C', '\0', '\0'};
+
+    static_assert(sizeof(SpectrumFile::Header) % sizeof(double) == 0, "payload must stay 8-byte aligned");
+    static_assert(sizeof(G4int) == sizeof(std::int32_t), "alias indices are stored as int32");
+
+    bool ModTime(const std::string &path, time_t &mtime) {
+        struct stat st{};
+        if (stat(path.c_str(), &st) != 0) return false;
+        mtime = st.st_mtime;
+        return true;
+    }
+
+    size_t PayloadBytes(const size_t nRaw, const size_t nGrid, const size_t nAux) {
+        const size_t nBins = nGrid > 0 ? nGrid - 1 : 0;
+        return (2 * nRaw + 2 * nGrid + nBins + nAux) * sizeof(double) + nBins * sizeof(std::int32_t);
+    }
+}
+
+
+SpectrumFile::~SpectrumFile() {
+    if (base) munmap(base, size);
+}
+
+
+std::uint64_t SpectrumFile::Checksum(const unsigned char *data, const size_t n) {
+    std::uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= data[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+
+std::string SpectrumFile::PathFor(const std::string &source, const std::string &stem) {
+    const size_t slash = source.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "" : source.substr(0, slash + 1);
+    if (!stem.empty()) return dir + stem + ".gcspec";
+
+    const std::string name = source.substr(dir.size());
+    const size_t dot = name.find_last_of('.');
+    return dir + (dot == std::string::npos ? name : name.substr(0, dot)) + ".gcspec";
+}
+
+
+std::shared_ptr<const SpectrumFile> SpectrumFile::Open(const std::string &path,
+                                                       const std::vector<std::string> &sources) {
+    time_t fileTime;
+    if (!ModTime(path, fileTime)) return nullptr;
+    for (const auto &src: sources) {
+        time_t srcTime;
+        if (ModTime(src, srcTime) && srcTime > fileTime) return nullptr;
+    }
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<SpectrumFile> file(new SpectrumFile());
+    file->base = base;
+    file->size = size;
+
+    const auto *bytes = static_cast<const unsigned char *>(base);
+    const auto *h = reinterpret_cast<const Header *>(bytes);
+    if (std::memcmp(h->magic, Magic, sizeof(Magic)) != 0 || h->version != Version || h->nGrid < 2 ||
+        h->payloadBytes != size - sizeof(Header) ||
+        h->payloadBytes != PayloadBytes(h->nRaw, h->nGrid, h->nAux) ||
+        h->checksum != Checksum(bytes + sizeof(Header), h->payloadBytes)) {
+        return nullptr;
+    }
+
+    const size_t nBins = h->nGrid - 1;
+    const auto *p = reinterpret_cast<const double *>(bytes + sizeof(Header));
+    file->header = h;
+    file->rawE = p;
+    file->rawFlux = p += h->nRaw;
+    file->logE = p += h->nRaw;
+    file->cdf = p += h->nGrid;
+    file->prob = p += h->nGrid;
+    file->aux = p += nBins;
+    file->alias = reinterpret_cast<const std::int32_t *>(p + h->nAux);
+    return file;
+}
+
+
+bool SpectrumFile::Write(const std::string &path, const Key &key,
+                         const std::vector<double> &rawE, const std::vector<double> &rawFlux,
+                         const Spectrum &spectrum, const std::vector<double> &aux) {
+    const size_t nRaw = std::min(rawE.size(), rawFlux.size());
+    const size_t nGrid = spectrum.Size();
+    if (nGrid < 2) return false;
+    const size_t nBins = nGrid - 1;
+
+    std::vector<unsigned char> payload(PayloadBytes(nRaw, nGrid, aux.size()));
+    unsigned char *out = payload.data();
+    auto put = [&out](const void *src, const size_t bytes) {
+        if (bytes == 0) return;
+        std::memcpy(out, src, bytes);
+        out += bytes;
+    };
+    put(rawE.data(), nRaw * sizeof(double));
+    put(rawFlux.data(), nRaw * sizeof(double));
+    put(spectrum.LogE(), nGrid * sizeof(double));
+    put(spectrum.CDF(), nGrid * sizeof(double));
+    put(spectrum.Table().Prob(), nBins * sizeof(double));
+    put(aux.data(), aux.size() * sizeof(double));
+    put(spectrum.Table().Alias(), nBins * sizeof(std::int32_t));
+
+    Header h{};
+    std::memcpy(h.magic, Magic, sizeof(Magic));
+    h.version = Version;
+    h.nRaw = static_cast<std::uint32_t>(nRaw);
+    h.nGrid = static_cast<std::uint32_t>(nGrid);
+    h.nAux = static_cast<std::uint32_t>(aux.size());
+    h.key = key;
+    h.Emin = spectrum.Emin();
+    h.Emax = spectrum.Emax();
+    h.payloadBytes = payload.size();
+    h.checksum = Checksum(payload.data(), payload.size());
+
+    // Unique per process and thread, since several threads of a job may write the same file
+    const std::string tmp = path + ".tmp." + std::to_string(getpid()) + "." +
+                            std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+        if (!os) return false;
+        os.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        os.write(reinterpret_cast<const char *>(payload.data()), static_cast<std::streamsize>(payload.size()));
+        if (!os) {
+            os.close();
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+std::shared_ptr<const Spectrum> SpectrumFile::MakeSpectrum() const {
+    return std::make_shared<const Spectrum>(shared_from_this(), logE, cdf, header->nGrid, prob,
+                                            reinterpret_cast<const G4int *>(alias), header->Emin, header->Emax);
+}
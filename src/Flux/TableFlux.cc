@@ -1,7 +1,7 @@
 #include "Flux/TableFlux.hh"
 
 
-TableFlux::TableFlux(const G4double cThreshold) {
+TableFlux::TableFlux(const G4double cThreshold, std::shared_ptr<const Spectrum> shared) {
     configFile = "../Flux_config/Table_params.txt";
     path = GetParam(configFile, "table_path", "../TableSpectrum/flare_M2.csv");
     particle = GetParam(configFile, "particle", "proton");
@@ -9,7 +9,42 @@ TableFlux::TableFlux(const G4double cThreshold) {
     Emin = std::max({GetParam(configFile, "E_min", 10.) * MeV, cThreshold});
     Emax = GetParam(configFile, "E_max", 100.) * MeV;
 
-    BuildCDF();
+    if (shared) {
+        UseSpectrum(std::move(shared));
+        return;
+    }
+
+    // The precompiled .gcspec next to the CSV is used as is when built for the same range,
+    // otherwise its raw table still saves the text parsing
+    const SpectrumFile::Key key{Emin, Emax, 0, 0};
+    const std::string binPath = SpectrumFile::PathFor(path);
+    const auto file = SpectrumFile::Open(binPath, {path});
+    if (file && file->GetKey() == key) {
+        UseSpectrum(file->MakeSpectrum());
+        return;
+    }
+
+    std::vector<Row> rows;
+    if (file) {
+        rows.reserve(file->RawSize());
+        for (size_t i = 0; i < file->RawSize(); ++i) rows.push_back({file->RawE()[i], file->RawFlux()[i]});
+    } else {
+        rows = ReadRows();
+    }
+
+    BuildCDF(rows);
+    UseSpectrum(std::make_shared<const Spectrum>(EList, CDF, Emin, Emax));
+
+    if (!file && rows.size() >= 2) {
+        std::vector<G4double> rawE, rawFlux;
+        rawE.reserve(rows.size());
+        rawFlux.reserve(rows.size());
+        for (const auto &[E, flux]: rows) {
+            rawE.push_back(E);
+            rawFlux.push_back(flux);
+        }
+        SpectrumFile::Write(binPath, key, rawE, rawFlux, *spectrum);
+    }
 }
 
 
@@ -22,28 +57,22 @@ inline std::vector<G4double> ExtractNumbers(const std::string &line) {
     return out;
 }
 
-void TableFlux::BuildCDF() {
-    EList.clear();
-    CDF.clear();
+std::vector<Row> TableFlux::ReadRows() const {
+    std::vector<Row> rows;
 
     if (path.empty()) {
-        G4Exception("TableFlux::BuildCDF", "NO_PATH",
+        G4Exception("TableFlux::ReadRows", "NO_PATH",
                     JustWarning, "CSV path is empty. Using trivial 2-point spectrum.");
-        EList = {1. * MeV, 10. * MeV};
-        CDF = {0.0, 1.0};
-        return;
+        return rows;
     }
 
     std::ifstream in(path.c_str());
     if (!in) {
-        G4Exception("TableFlux::BuildCDF", "CSV_OPEN_FAIL",
+        G4Exception("TableFlux::ReadRows", "CSV_OPEN_FAIL",
                     JustWarning, ("Cannot open " + path + ", using trivial spectrum.").c_str());
-        EList = {1. * MeV, 10. * MeV};
-        CDF = {0.0, 1.0};
-        return;
+        return rows;
     }
 
-    std::vector<Row> rows;
     rows.reserve(2048);
 
     std::string line;
@@ -56,6 +85,12 @@ void TableFlux::BuildCDF() {
         rows.push_back({E_G4, flx});
     }
     in.close();
+    return rows;
+}
+
+void TableFlux::BuildCDF(std::vector<Row> rows) {
+    EList.clear();
+    CDF.clear();
 
     if (rows.size() < 2) {
         G4Exception("TableFlux::BuildCDF", "CSV_NO_ROWS",
@@ -169,23 +204,6 @@ void TableFlux::BuildCDF() {
 }
 
 G4double TableFlux::SampleEnergy() {
-    if (EList.size() < 2) return 1.0 * MeV;
-
-    const G4double u = G4UniformRand();
-
-    const auto it = std::upper_bound(CDF.begin(), CDF.end(), u);
-    if (it == CDF.begin()) return EList.front();
-    if (it == CDF.end()) return EList.back();
-
-    const size_t j = static_cast<size_t>(std::distance(CDF.begin(), it));
-    const size_t i = j - 1;
-
-    const G4double C0 = CDF[i];
-    const G4double C1 = CDF[j];
-    const G4double t = (u - C0) / std::max(C1 - C0, 1e-12);
-
-    const G4double lnE0 = std::log(EList[i]);
-    const G4double lnE1 = std::log(EList[j]);
-    const G4double lnEu = lnE0 + t * (lnE1 - lnE0);
-    return std::exp(lnEu);
+    if (spectrum->Empty()) return 1.0 * MeV;
+    return spectrum->Sample();
 }
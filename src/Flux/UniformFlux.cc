@@ -73,7 +73,21 @@ G4double UniformFlux::SampleEnergy() {
     const size_t idx = SampleIndex();
     Emin = std::max({EminVec[idx] * MeV, eCrystalThreshold});
     Emax = EmaxVec[idx] * MeV;
-    particle = particles[idx];
+    current = idx;
 
     return Emin * std::pow(Emax / Emin, G4UniformRand());;
-}
\ No newline at end of file
+}
+
+
+ParticleInfo UniformFlux::GenerateSpecies() {
+    current = SampleIndex();
+    return Flux::GenerateSpecies();
+}
+
+
+G4ParticleDefinition *UniformFlux::Definition() {
+    if (definitions.empty()) {
+        for (const auto &p: particles) definitions.push_back(FindDefinition(p));
+    }
+    return definitions[current];
+}
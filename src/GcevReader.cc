@@ -0,0 +1,197 @@
+#include "GcevReader.hh"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+    // Just enough JSON for index.json: objects, arrays, strings and numbers
+    struct Json {
+        enum Kind { Null, Number, String, Array, Object } kind = Null;
+        double number = 0;
+        std::string text;
+        std::vector<Json> items;
+        std::vector<std::pair<std::string, Json>> members;
+
+        [[nodiscard]] const Json *Get(const std::string &key) const {
+            for (const auto &[k, v]: members) {
+                if (k == key) return &v;
+            }
+            return nullptr;
+        }
+
+        [[nodiscard]] const Json &At(const std::string &key) const {
+            const Json *v = Get(key);
+            if (!v) throw std::runtime_error("gcev index: missing \"" + key + "\"");
+            return *v;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string &s) : s(s) {}
+
+        Json Parse() {
+            Json v = Value();
+            Skip();
+            if (p != s.size()) Fail();
+            return v;
+        }
+
+    private:
+        const std::string &s;
+        size_t p = 0;
+
+        [[noreturn]] void Fail() const {
+            throw std::runtime_error("gcev index: malformed JSON at offset " + std::to_string(p));
+        }
+
+        void Skip() {
+            while (p < s.size() && (s[p] == ' ' || s[p] == '\n' || s[p] == '\r' || s[p] == '\t')) ++p;
+        }
+
+        bool Eat(const char c) {
+            Skip();
+            if (p < s.size() && s[p] == c) {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+
+        std::string Text() {
+            if (!Eat('"')) Fail();
+            std::string out;
+            while (p < s.size() && s[p] != '"') {
+                if (s[p] == '\\' && p + 1 < s.size()) ++p;
+                out += s[p++];
+            }
+            if (p == s.size()) Fail();
+            ++p;
+            return out;
+        }
+
+        Json Value() {
+            Skip();
+            if (p == s.size()) Fail();
+            Json v;
+            if (s[p] == '{') {
+                ++p;
+                v.kind = Json::Object;
+                if (Eat('}')) return v;
+                do {
+                    std::string key = Text();
+                    if (!Eat(':')) Fail();
+                    v.members.emplace_back(std::move(key), Value());
+                } while (Eat(','));
+                if (!Eat('}')) Fail();
+            } else if (s[p] == '[') {
+                ++p;
+                v.kind = Json::Array;
+                if (Eat(']')) return v;
+                do {
+                    v.items.push_back(Value());
+                } while (Eat(','));
+                if (!Eat(']')) Fail();
+            } else if (s[p] == '"') {
+                v.kind = Json::String;
+                v.text = Text();
+            } else {
+                size_t used = 0;
+                try {
+                    v.number = std::stod(s.substr(p, 32), &used);
+                } catch (const std::exception &) {
+                    Fail();
+                }
+                v.kind = Json::Number;
+                p += used;
+            }
+            return v;
+        }
+    };
+}
+
+
+GcevReader::GcevReader(std::string dirName) : dir(std::move(dirName)) {
+    std::ifstream in(dir + "/index.json");
+    if (!in) throw std::runtime_error("Failed to open gcev index: " + dir + "/index.json");
+    std::stringstream ss;
+    ss << in.rdbuf();
+    const std::string text = ss.str();
+
+    const Json root = JsonParser(text).Parse();
+    if (root.At("format").text != "gcev" || static_cast<int>(root.At("version").number) != 1) {
+        throw std::runtime_error("Unsupported gcev store: " + dir);
+    }
+
+    for (const Json &t: root.At("tables").items) {
+        Table table;
+        table.name = t.At("name").text;
+        table.title = t.At("title").text;
+        for (const Json &c: t.At("columns").items) {
+            Column col;
+            col.name = c.At("name").text;
+            col.type = c.At("type").text;
+            if (col.type != "i4" && col.type != "f4" && col.type != "f8") {
+                throw std::runtime_error("gcev index: unknown column type " + col.type);
+            }
+            if (const Json *dict = c.Get("dictionary")) {
+                col.encoded = true;
+                for (const Json &word: dict->items) col.dictionary.push_back(word.text);
+            }
+            table.columns.push_back(std::move(col));
+        }
+        for (const Json &seg: t.At("segments").items) {
+            table.segments.push_back({static_cast<int>(seg.At("thread").number),
+                                      static_cast<size_t>(seg.At("rows").number)});
+        }
+        tables.push_back(std::move(table));
+    }
+}
+
+
+GcevReader::~GcevReader() {
+    for (const auto &[key, m]: mappings) munmap(m.base, m.size);
+}
+
+
+const GcevReader::Table *GcevReader::Find(const std::string &name) const {
+    for (const Table &t: tables) {
+        if (t.name == name) return &t;
+    }
+    return nullptr;
+}
+
+
+const void *GcevReader::Map(const Table &table, const size_t column, const size_t segment) {
+    const Column &col = table.columns.at(column);
+    const Segment &seg = table.segments.at(segment);
+    if (seg.rows == 0) return nullptr;
+
+    const auto key = std::make_tuple(table.name, column, segment);
+    if (const auto it = mappings.find(key); it != mappings.end()) return it->second.base;
+
+    const std::string path = dir + "/" + table.name + "." + col.name + "." + std::to_string(seg.thread) + ".col";
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open gcev column: " + path);
+
+    struct stat st{};
+    const size_t size = seg.rows * col.Width();
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != size) {
+        close(fd);
+        throw std::runtime_error("gcev column does not match the index: " + path);
+    }
+
+    void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) throw std::runtime_error("Failed to map gcev column: " + path);
+    mappings.emplace(key, Mapping{base, size});
+    return base;
+}
@@ -0,0 +1,212 @@
+#include "GcevStore.hh"
+
+#include <G4Exception.hh>
+#include <G4Threading.hh>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+
+G4Mutex GcevStore::mutex = G4MUTEX_INITIALIZER;
+std::vector<std::vector<G4String>> GcevStore::dictionaries;
+std::vector<std::unordered_map<std::string, G4int>> GcevStore::codes;
+std::vector<std::vector<GcevStore::Segment>> GcevStore::segments;
+
+namespace {
+    constexpr size_t flushBytes = 1 << 20;  // per column
+
+    size_t Width(const char type) {
+        return type == 'D' ? 8 : 4;
+    }
+
+    const char *TypeName(const char type) {
+        if (type == 'F') return "f4";
+        if (type == 'D') return "f8";
+        return "i4";
+    }
+
+    std::string Quote(const std::string &s) {
+        std::string out = "\"";
+        for (const char c: s) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) continue;
+            out += c;
+        }
+        return out + "\"";
+    }
+}
+
+
+G4String GcevStore::DirFor(const G4String &outputFile) {
+    G4String stem = outputFile;
+    if (stem.size() > 5 && stem.compare(stem.size() - 5, 5, ".root") == 0) stem.erase(stem.size() - 5);
+    return stem + ".gcev";
+}
+
+
+void GcevStore::Begin(const G4String &dir) {
+    G4AutoLock lock(&mutex);
+    std::error_code ec;
+    fs::remove_all(dir.c_str(), ec);
+    fs::create_directories(dir.c_str(), ec);
+    if (ec) {
+        G4Exception("GcevStore::Begin", "GcevOutput", FatalException,
+                    ("cannot create " + dir + ": " + ec.message()).c_str());
+    }
+    dictionaries.clear();
+    codes.clear();
+    segments.clear();
+}
+
+
+G4int GcevStore::Intern(const G4int table, const G4String &text) {
+    G4AutoLock lock(&mutex);
+    const size_t t = static_cast<size_t>(table);
+    if (t >= dictionaries.size()) {
+        dictionaries.resize(t + 1);
+        codes.resize(t + 1);
+    }
+    const auto it = codes[t].find(text);
+    if (it != codes[t].end()) return it->second;
+    const G4int code = static_cast<G4int>(dictionaries[t].size());
+    dictionaries[t].push_back(text);
+    codes[t].emplace(text, code);
+    return code;
+}
+
+
+void GcevStore::AddSegment(const G4int table, const G4int thread, const size_t rows) {
+    G4AutoLock lock(&mutex);
+    const size_t t = static_cast<size_t>(table);
+    if (t >= segments.size()) segments.resize(t + 1);
+    segments[t].push_back({thread, rows});
+}
+
+
+void GcevStore::WriteIndex(const G4String &dir) {
+    const std::vector<NtupleSchema::Table> tables = NtupleSchema::Instance().Tables();
+    G4AutoLock lock(&mutex);
+
+    const fs::path path = fs::path(dir.c_str()) / "index.json";
+    const fs::path tmp = fs::path(dir.c_str()) / "index.json.tmp";
+    std::ofstream out(tmp);
+    if (!out) {
+        G4Exception("GcevStore::WriteIndex", "GcevOutput", FatalException, ("cannot write " + tmp.string()).c_str());
+        return;
+    }
+
+    out << "{\n  \"format\": \"gcev\",\n  \"version\": 1,\n  \"tables\": [";
+    for (size_t t = 0; t < tables.size(); ++t) {
+        const NtupleSchema::Table &table = tables[t];
+        out << (t ? "," : "") << "\n    {\n      \"name\": " << Quote(table.name)
+                << ",\n      \"title\": " << Quote(table.title) << ",\n      \"columns\": [";
+        for (size_t c = 0; c < table.columns.size(); ++c) {
+            const NtupleSchema::Column &col = table.columns[c];
+            out << (c ? "," : "") << "\n        {\"name\": " << Quote(col.name)
+                    << ", \"type\": \"" << TypeName(col.type) << "\"";
+            if (col.type == 'S') {
+                out << ", \"dictionary\": [";
+                if (t < dictionaries.size()) {
+                    for (size_t k = 0; k < dictionaries[t].size(); ++k) out << (k ? ", " : "") << Quote(dictionaries[t][k]);
+                }
+                out << "]";
+            }
+            out << "}";
+        }
+        out << "\n      ],\n      \"segments\": [";
+        if (t < segments.size()) {
+            std::vector<Segment> segs = segments[t];
+            std::sort(segs.begin(), segs.end(), [](const Segment &a, const Segment &b) { return a.thread < b.thread; });
+            for (size_t s = 0; s < segs.size(); ++s) {
+                out << (s ? ", " : "") << "{\"thread\": " << segs[s].thread << ", \"rows\": " << segs[s].rows << "}";
+            }
+        }
+        out << "]\n    }";
+    }
+    out << "\n  ]\n}\n";
+    out.close();
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        G4Exception("GcevStore::WriteIndex", "GcevOutput", FatalException,
+                    ("cannot write " + path.string() + ": " + ec.message()).c_str());
+    }
+}
+
+
+GcevWriter::GcevWriter(const G4String &dir, const G4int thread) : dir(dir), thread(thread) {}
+
+
+GcevWriter::~GcevWriter() {
+    Close();
+}
+
+
+GcevWriter::Sink &GcevWriter::Open(const G4int table) {
+    const size_t t = static_cast<size_t>(table);
+    if (t >= sinks.size()) sinks.resize(t + 1);
+    Sink &sink = sinks[t];
+    if (!sink.files.empty()) return sink;
+
+    sink.table = NtupleSchema::Instance().GetTable(table);
+    for (const NtupleSchema::Column &col: sink.table.columns) {
+        const G4String path = dir + "/" + sink.table.name + "." + col.name + "." + std::to_string(thread) + ".col";
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            G4Exception("GcevWriter::Open", "GcevOutput", FatalException, ("cannot open " + path).c_str());
+        }
+        sink.files.push_back(file);
+        sink.buffers.emplace_back();
+        sink.buffers.back().reserve(flushBytes + 8);
+    }
+    return sink;
+}
+
+
+void GcevWriter::Flush(std::FILE *file, std::vector<char> &buffer) {
+    if (buffer.empty()) return;
+    if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        G4Exception("GcevWriter::Flush", "GcevOutput", FatalException, "short write to a column file");
+    }
+    buffer.clear();
+}
+
+
+void GcevWriter::Append(const NtupleRecord &record) {
+    Sink &sink = Open(record.table);
+    for (size_t c = 0; c < sink.table.columns.size(); ++c) {
+        const char type = sink.table.columns[c].type;
+        std::vector<char> &buffer = sink.buffers[c];
+        if (type == 'S') {
+            const std::string text(record.str);
+            auto it = sink.codes.find(text);
+            if (it == sink.codes.end()) it = sink.codes.emplace(text, GcevStore::Intern(record.table, text)).first;
+            const char *p = reinterpret_cast<const char *>(&it->second);
+            buffer.insert(buffer.end(), p, p + 4);
+        } else {
+            const char *p = reinterpret_cast<const char *>(&record.values[c]);
+            buffer.insert(buffer.end(), p, p + Width(type));
+        }
+        if (buffer.size() >= flushBytes) Flush(sink.files[c], buffer);
+    }
+    ++sink.rows;
+}
+
+
+void GcevWriter::Close() {
+    for (size_t t = 0; t < sinks.size(); ++t) {
+        Sink &sink = sinks[t];
+        if (sink.files.empty()) continue;
+        for (size_t c = 0; c < sink.files.size(); ++c) {
+            Flush(sink.files[c], sink.buffers[c]);
+            std::fclose(sink.files[c]);
+        }
+        GcevStore::AddSegment(static_cast<G4int>(t), thread, sink.rows);
+        sink = Sink{};
+    }
+    sinks.clear();
+}
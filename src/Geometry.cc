@@ -181,6 +181,12 @@ G4VPhysicalVolume* Geometry::Construct() {
     ConstructDetector();
     ConstructTunaCan();
 
+    if (crystalFastOptics) {
+        crystalRegion = new G4Region("CrystalRegion");
+        crystalLV->SetRegion(crystalRegion);
+        crystalRegion->AddRootLogicalVolume(crystalLV);
+    }
+
     return worldPVP;
 }
 
@@ -217,8 +223,13 @@ void Geometry::ConstructSDandField() {
     if (useOptics) {
         auto* sipmSD = new SiPMOpticalSD("SiPMOpticalSD");
         auto* sipmWindowLV = detector->GetSiPMWindowLV();
-        sipmSD->SetSiPMWindowLV(sipmWindowLV);
+        sipmSD->SetRegistry(&detector->GetSiPMRegistry());
         sdManager->AddNewDetector(sipmSD);
         sipmWindowLV->SetSensitiveDetector(sipmSD);
     }
+
+    // Models are thread-local: each worker attaches its own to the shared region
+    if (crystalFastOptics) {
+        new CrystalFastOptics("CrystalFastOptics", G4RegionStore::GetInstance()->GetRegion("CrystalRegion"));
+    }
 }
@@ -0,0 +1,41 @@
+#include "InteractionCodes.hh"
+
+
+namespace {
+    G4Mutex codesMutex = G4MUTEX_INITIALIZER;
+    std::unordered_map<std::string, G4int> codes[3];
+    std::vector<G4String> names[3];
+}
+
+
+G4int InteractionCodes::Lookup(const CodeKind kind, const void *key, const G4String &name) {
+    auto &c = cache[static_cast<int>(kind)];
+    const auto it = c.find(key);
+    if (it != c.end()) return it->second;
+    return c[key] = Code(kind, name);
+}
+
+
+G4int InteractionCodes::Code(const CodeKind kind, const G4String &name) {
+    G4AutoLock lock(&codesMutex);
+    const int k = static_cast<int>(kind);
+    const auto [it, inserted] = codes[k].try_emplace(name, static_cast<G4int>(names[k].size()));
+    if (inserted) names[k].push_back(name);
+    return it->second;
+}
+
+
+std::vector<G4String> InteractionCodes::Names(const CodeKind kind) {
+    G4AutoLock lock(&codesMutex);
+    return names[static_cast<int>(kind)];
+}
+
+
+const char *InteractionCodes::KindName(const CodeKind kind) {
+    switch (kind) {
+        case CodeKind::Process: return "process";
+        case CodeKind::Volume: return "volume";
+        case CodeKind::Particle: return "particle";
+    }
+    return "";
+}
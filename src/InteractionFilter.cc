@@ -0,0 +1,58 @@
+#include "InteractionFilter.hh"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "Utils.hh"
+
+
+InteractionFilter::InteractionFilter(const G4String &path) {
+    if (path.empty()) return;
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        G4Exception("InteractionFilter::InteractionFilter", "FILE_OPEN_FAIL", FatalException,
+                    ("Cannot open secondaries filter " + path).c_str());
+        return;
+    }
+
+    std::unordered_map<std::string, G4String> spec;
+    G4String line;
+    while (std::getline(in, line)) {
+        const size_t pos = line.find(':');
+        if (pos == G4String::npos) continue;
+        const G4String key = Utils::Trim(line.substr(0, pos));
+        const G4String val = Utils::Trim(line.substr(pos + 1));
+        if (!key.empty() && !val.empty()) spec[key] = val;
+    }
+
+    try {
+        if (spec.count("volumes")) volumes = Compile(CodeKind::Volume, spec["volumes"]);
+        if (spec.count("processes")) processes = Compile(CodeKind::Process, spec["processes"]);
+        if (spec.count("particles")) particles = Compile(CodeKind::Particle, spec["particles"]);
+        if (spec.count("E_min")) eMin = std::stod(spec["E_min"]) * MeV;
+        if (spec.count("max_depth")) maxDepth = std::stoi(spec["max_depth"]);
+    } catch (const std::exception &e) {
+        G4Exception("InteractionFilter::InteractionFilter", "BAD_CONFIG", FatalException,
+                    ("Bad value in " + path + ": " + e.what()).c_str());
+    }
+}
+
+
+std::vector<char> InteractionFilter::Compile(const CodeKind kind, const G4String &line) {
+    std::vector<G4int> codes;
+    std::stringstream ss(line);
+    G4String name;
+    while (std::getline(ss, name, ',')) {
+        name = Utils::Trim(name);
+        if (!name.empty()) codes.push_back(InteractionCodes::Code(kind, name));
+    }
+
+    std::vector<char> mask;
+    for (const G4int c: codes) {
+        if (c >= static_cast<G4int>(mask.size())) mask.resize(c + 1, 0);
+        mask[c] = 1;
+    }
+    return mask;
+}
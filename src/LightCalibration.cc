@@ -0,0 +1,129 @@
+#include "LightCalibration.hh"
+
+
+LightCalibration::LightCalibration() {
+    auto *store = G4PhysicalVolumeStore::GetInstance();
+    const G4int n = std::max(Configuration::lutVoxels, 1);
+
+    for (G4int s = 0; s < LightLUT::nSources; ++s) {
+        const auto *pv = store->GetVolume(LightLUT::SourcePV[s], false);
+        if (!pv) {
+            G4Exception("LightCalibration::LightCalibration", "NoVolume", FatalException,
+                        (G4String("Scintillator volume not found: ") + LightLUT::SourcePV[s]).c_str());
+            return;
+        }
+        auto &em = emitters[s];
+        em.solid = pv->GetLogicalVolume()->GetSolid();
+        em.toWorld = LightLUT::ToWorld(pv);
+
+        auto &src = grid.sources[s];
+        src.nx = src.ny = src.nz = n;
+        em.solid->BoundingLimits(src.lo, src.hi);
+
+        const auto *mpt = pv->GetLogicalVolume()->GetMaterial()->GetMaterialPropertiesTable();
+        em.fast = MakeSpectrum(mpt, "SCINTILLATIONCOMPONENT1");
+        em.slow = MakeSpectrum(mpt, "SCINTILLATIONCOMPONENT2");
+        if (!em.slow.e.empty() && mpt->ConstPropertyExists("SCINTILLATIONYIELD2")) {
+            em.slowShare = mpt->GetConstProperty("SCINTILLATIONYIELD2");
+        }
+        if (em.fast.e.empty()) {
+            G4Exception("LightCalibration::LightCalibration", "NoEmission", FatalException,
+                        (G4String("No scintillation spectrum in the material of ") + LightLUT::SourcePV[s]).c_str());
+        }
+
+        // Keep voxels where a 3x3x3 probe finds the solid
+        const G4ThreeVector size = src.VoxelSize();
+        for (G4int v = 0; v < src.NVoxels(); ++v) {
+            const G4ThreeVector low = src.VoxelLow(v);
+            G4bool any = false;
+            for (G4int p = 0; p < 27 && !any; ++p) {
+                const G4ThreeVector probe(low.x() + (p % 3 + 0.5) / 3 * size.x(),
+                                          low.y() + (p / 3 % 3 + 0.5) / 3 * size.y(),
+                                          low.z() + (p / 9 + 0.5) / 3 * size.z());
+                any = em.solid->Inside(probe) == kInside;
+            }
+            if (any) voxels.emplace_back(s, v);
+        }
+    }
+    LightLUT::BeginCalibration(grid);
+}
+
+
+LightCalibration::Spectrum LightCalibration::MakeSpectrum(const G4MaterialPropertiesTable *mpt, const char *key) {
+    Spectrum sp;
+    auto *v = mpt ? mpt->GetProperty(key) : nullptr;
+    if (!v || v->GetVectorLength() < 2) return sp;
+
+    const size_t n = v->GetVectorLength();
+    sp.e.resize(n);
+    sp.cdf.assign(n, 0.0);
+    for (size_t i = 0; i < n; ++i) sp.e[i] = v->Energy(i);
+    for (size_t i = 1; i < n; ++i) {
+        sp.cdf[i] = sp.cdf[i - 1] + 0.5 * ((*v)[i] + (*v)[i - 1]) * (sp.e[i] - sp.e[i - 1]);
+    }
+    if (sp.cdf.back() <= 0.0) return {};
+    for (auto &c: sp.cdf) c /= sp.cdf.back();
+    return sp;
+}
+
+
+// Linear inside the bin, which is exact for a piecewise-constant density and close enough here
+G4double LightCalibration::Spectrum::Sample(const G4double u) const {
+    const size_t i = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+    if (i == 0) return e.front();
+    if (i >= cdf.size()) return e.back();
+    const G4double f = cdf[i] > cdf[i - 1] ? (u - cdf[i - 1]) / (cdf[i] - cdf[i - 1]) : 0.0;
+    return e[i - 1] + f * (e[i] - e[i - 1]);
+}
+
+
+G4bool LightCalibration::Inside(const G4int source, const G4int voxel, G4ThreeVector &local) const {
+    const auto &src = grid.sources[source];
+    const G4ThreeVector low = src.VoxelLow(voxel);
+    const G4ThreeVector size = src.VoxelSize();
+    for (G4int i = 0; i < maxTries; ++i) {
+        local.set(low.x() + G4UniformRand() * size.x(),
+                  low.y() + G4UniformRand() * size.y(),
+                  low.z() + G4UniformRand() * size.z());
+        if (emitters[source].solid->Inside(local) == kInside) return true;
+    }
+    return false;
+}
+
+
+LUTEmission LightCalibration::Generate(G4Event *evt) {
+    LUTEmission out;
+    if (voxels.empty()) return out;
+
+    const auto [s, v] = voxels[static_cast<size_t>(evt->GetEventID()) % voxels.size()];
+    const auto &em = emitters[s];
+    out.source = s;
+    out.voxel = v;
+
+    for (G4int n = 0; n < Configuration::lutPhotons; ++n) {
+        G4ThreeVector pos;
+        if (!Inside(s, v, pos)) continue;
+        for (const auto &t: em.toWorld) pos = t.TransformPoint(pos);
+
+        const G4double cosT = 2.0 * G4UniformRand() - 1.0;
+        const G4double sinT = std::sqrt(std::max(0.0, 1.0 - cosT * cosT));
+        const G4double phi = twopi * G4UniformRand();
+        const G4ThreeVector dir(sinT * std::cos(phi), sinT * std::sin(phi), cosT);
+        G4ThreeVector pol = dir.orthogonal().unit();
+        pol.rotate(twopi * G4UniformRand(), dir);
+
+        const G4bool slow = em.slowShare > 0.0 && G4UniformRand() < em.slowShare;
+        const G4double energy = (slow ? em.slow : em.fast).Sample(G4UniformRand());
+
+        auto *photon = new G4PrimaryParticle(G4OpticalPhoton::Definition());
+        photon->SetMomentumDirection(dir);
+        photon->SetKineticEnergy(energy);
+        photon->SetPolarization(pol);
+
+        auto *vertex = new G4PrimaryVertex(pos, 0.0);
+        vertex->SetPrimary(photon);
+        evt->AddPrimaryVertex(vertex);
+        ++out.emitted;
+    }
+    return out;
+}
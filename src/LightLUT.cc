@@ -0,0 +1,224 @@
+#include "LightLUT.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+
+#include "Configuration.hh"
+#include "SiPMOpticalSD.hh"
+
+
+namespace {
+    G4Mutex lutMutex = G4MUTEX_INITIALIZER;
+    std::shared_ptr<const LightLUT> shared;
+    G4String sharedPath;
+
+    // Calibration tally: the grid plus detected photons per (group, channel) and voxel
+    LightLUT calibration;
+    std::map<std::pair<G4int, G4int>, std::vector<G4double>> detected[LightLUT::nSources];
+
+    void TallyGroup(const G4int source, const G4int voxel, const SiPMGroup group,
+                    const std::vector<SiPMChannel> &perCh) {
+        const G4int nVox = calibration.sources[source].NVoxels();
+        for (G4int ch = 0; ch < static_cast<G4int>(perCh.size()); ++ch) {
+            const SiPMChannel &c = perCh[ch];
+            if (!c.Hit()) continue;
+            auto &d = detected[source][{static_cast<G4int>(group), ch}];
+            if (d.empty()) d.assign(nVox, 0.0);
+            d[voxel] += c.npe;
+        }
+    }
+}
+
+
+G4int LightLUT::Source::Voxel(const G4ThreeVector &local) const {
+    const G4ThreeVector size = VoxelSize();
+    const G4int i = static_cast<G4int>(std::floor((local.x() - lo.x()) / size.x()));
+    const G4int j = static_cast<G4int>(std::floor((local.y() - lo.y()) / size.y()));
+    const G4int k = static_cast<G4int>(std::floor((local.z() - lo.z()) / size.z()));
+    if (i < 0 || i >= nx || j < 0 || j >= ny || k < 0 || k >= nz) return -1;
+    return (k * ny + j) * nx + i;
+}
+
+
+G4ThreeVector LightLUT::Source::VoxelLow(const G4int voxel) const {
+    const G4ThreeVector size = VoxelSize();
+    const G4int i = voxel % nx;
+    const G4int j = voxel / nx % ny;
+    const G4int k = voxel / (nx * ny);
+    return {lo.x() + i * size.x(), lo.y() + j * size.y(), lo.z() + k * size.z()};
+}
+
+
+G4ThreeVector LightLUT::Source::VoxelSize() const {
+    return {(hi.x() - lo.x()) / nx, (hi.y() - lo.y()) / ny, (hi.z() - lo.z()) / nz};
+}
+
+
+G4String LightLUT::DefaultPath() {
+    return "../LightLUT/" + Configuration::detectorType + "_" + Configuration::crystalSiPMConfig + ".lut";
+}
+
+
+std::shared_ptr<const LightLUT> LightLUT::Shared(const G4String &path) {
+    G4AutoLock lock(&lutMutex);
+    if (shared && sharedPath == path) return shared;
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        G4Exception("LightLUT::Shared", "FILE_OPEN_FAIL", FatalException,
+                    ("Cannot open light-collection table " + path + " (run with --lut-calibrate first)").c_str());
+        return nullptr;
+    }
+    auto lut = std::make_shared<LightLUT>();
+    lut->Read(in, path);
+    shared = lut;
+    sharedPath = path;
+    return shared;
+}
+
+
+std::vector<G4AffineTransform> LightLUT::ToWorld(const G4VPhysicalVolume *pv) {
+    std::vector<G4AffineTransform> chain;
+    const auto *store = G4PhysicalVolumeStore::GetInstance();
+    while (pv) {
+        chain.emplace_back(pv->GetRotation(), pv->GetTranslation());
+        const auto *mother = pv->GetMotherLogical();
+        if (!mother) break;
+        const auto it = std::find_if(store->begin(), store->end(),
+                                     [mother](const G4VPhysicalVolume *p) { return p->GetLogicalVolume() == mother; });
+        pv = it != store->end() ? *it : nullptr;
+    }
+    return chain;
+}
+
+
+void LightLUT::BeginCalibration(const LightLUT &grid) {
+    G4AutoLock lock(&lutMutex);
+    if (calibration.sources[0].NVoxels() > 0) return;
+    calibration = grid;
+    for (G4int s = 0; s < nSources; ++s) {
+        calibration.sources[s].emitted.assign(grid.sources[s].NVoxels(), 0.0);
+        detected[s].clear();
+    }
+}
+
+
+void LightLUT::Tally(const G4int source, const G4int voxel, const G4double emitted, const SiPMOpticalSD &sd) {
+    G4AutoLock lock(&lutMutex);
+    if (source < 0 || source >= nSources || voxel < 0 || voxel >= calibration.sources[source].NVoxels()) return;
+
+    calibration.sources[source].emitted[voxel] += emitted;
+    TallyGroup(source, voxel, SiPMGroup::Crystal, sd.GetPerChannelCrystal());
+    TallyGroup(source, voxel, SiPMGroup::Veto, sd.GetPerChannelVeto());
+    TallyGroup(source, voxel, SiPMGroup::Bottom, sd.GetPerChannelBottom());
+}
+
+
+void LightLUT::WriteCalibration(const G4String &path) {
+    G4AutoLock lock(&lutMutex);
+    LightLUT lut = calibration;
+    for (G4int s = 0; s < nSources; ++s) {
+        auto &src = lut.sources[s];
+        const size_t nCh = detected[s].size();
+        src.channels.clear();
+        src.prob.assign(src.NVoxels() * nCh, 0.0);
+
+        size_t c = 0;
+        for (const auto &[key, d]: detected[s]) {
+            src.channels.push_back({static_cast<SiPMGroup>(key.first), key.second});
+            for (G4int v = 0; v < src.NVoxels(); ++v) {
+                if (src.emitted[v] > 0.0) src.prob[v * nCh + c] = d[v] / src.emitted[v];
+            }
+            ++c;
+        }
+    }
+
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    std::error_code ec;
+    if (!dir.empty()) std::filesystem::create_directories(dir, ec);
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        G4Exception("LightLUT::WriteCalibration", "FILE_OPEN_FAIL", JustWarning,
+                    ("Cannot write light-collection table " + path).c_str());
+        return;
+    }
+    lut.Write(out);
+    G4cout << "Light-collection table written to " << path << G4endl;
+}
+
+
+// Text format, one block per source:
+//   source <index> <nx> <ny> <nz> <lo x y z> <hi x y z> <n channels>   (mm)
+//   channels <group>:<ch> ...
+//   <emitted> <p_1> ... <p_n>                                         (one line per voxel)
+void LightLUT::Write(std::ostream &out) const {
+    out << "# GammaCube light-collection table\n";
+    out << "# detector " << Configuration::detectorType << " sipm " << Configuration::crystalSiPMConfig << "\n";
+    out.precision(8);
+    for (G4int s = 0; s < nSources; ++s) {
+        const auto &src = sources[s];
+        out << "source " << s << " " << src.nx << " " << src.ny << " " << src.nz << " "
+            << src.lo.x() / mm << " " << src.lo.y() / mm << " " << src.lo.z() / mm << " "
+            << src.hi.x() / mm << " " << src.hi.y() / mm << " " << src.hi.z() / mm << " "
+            << src.channels.size() << "\n";
+        out << "channels";
+        for (const auto &c: src.channels) out << " " << static_cast<G4int>(c.group) << ":" << c.ch;
+        out << "\n";
+        const size_t nCh = src.channels.size();
+        for (G4int v = 0; v < src.NVoxels(); ++v) {
+            out << src.emitted[v];
+            for (size_t c = 0; c < nCh; ++c) out << " " << src.prob[v * nCh + c];
+            out << "\n";
+        }
+    }
+}
+
+
+void LightLUT::Read(std::istream &in, const G4String &path) {
+    auto fail = [&path](const G4String &what) {
+        G4Exception("LightLUT::Read", "BadFormat", FatalException,
+                    ("Malformed light-collection table " + path + ": " + what).c_str());
+    };
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream head(line);
+        std::string tag;
+        G4int s = -1;
+        size_t nCh = 0;
+        G4double lx, ly, lz, hx, hy, hz;
+        head >> tag >> s;
+        if (tag != "source" || s < 0 || s >= nSources) fail("expected 'source <index>'");
+
+        auto &src = sources[s];
+        head >> src.nx >> src.ny >> src.nz >> lx >> ly >> lz >> hx >> hy >> hz >> nCh;
+        if (!head || src.nx < 1 || src.ny < 1 || src.nz < 1) fail("bad grid of source " + std::to_string(s));
+        src.lo.set(lx * mm, ly * mm, lz * mm);
+        src.hi.set(hx * mm, hy * mm, hz * mm);
+
+        std::getline(in, line);
+        std::istringstream chans(line);
+        chans >> tag;
+        if (tag != "channels") fail("expected 'channels' after source " + std::to_string(s));
+        src.channels.clear();
+        for (std::string tok; chans >> tok;) {
+            const size_t colon = tok.find(':');
+            if (colon == std::string::npos) fail("bad channel " + tok);
+            src.channels.push_back({static_cast<SiPMGroup>(std::stoi(tok.substr(0, colon))),
+                                    std::stoi(tok.substr(colon + 1))});
+        }
+        if (src.channels.size() != nCh) fail("channel count of source " + std::to_string(s));
+
+        src.emitted.assign(src.NVoxels(), 0.0);
+        src.prob.assign(src.NVoxels() * nCh, 0.0);
+        for (G4int v = 0; v < src.NVoxels(); ++v) {
+            in >> src.emitted[v];
+            for (size_t c = 0; c < nCh; ++c) in >> src.prob[v * nCh + c];
+        }
+        if (!in) fail("truncated voxel table of source " + std::to_string(s));
+    }
+}
@@ -0,0 +1,83 @@
+#include "LightLUTSampler.hh"
+
+
+LightLUTSampler::LightLUTSampler(const G4int source)
+    : lut(LightLUT::Shared(Configuration::lutFile)), src(&lut->sources[source]) {}
+
+
+void LightLUTSampler::ReadMaterial(const G4Material *mat) {
+    material = mat;
+    const auto *mpt = mat->GetMaterialPropertiesTable();
+    yield = mpt && mpt->ConstPropertyExists("SCINTILLATIONYIELD") ? mpt->GetConstProperty("SCINTILLATIONYIELD") : 0.0;
+    resolution = mpt && mpt->ConstPropertyExists("RESOLUTIONSCALE") ? mpt->GetConstProperty("RESOLUTIONSCALE") : 1.0;
+    birks = mat->GetIonisation()->GetBirksConstant();
+}
+
+
+// Birks' law on the ionising part of the deposit, as G4EmSaturation does for charged steps
+G4double LightLUTSampler::VisibleEnergy(const G4Step *step) const {
+    const G4double edep = step->GetTotalEnergyDeposit();
+    const G4double length = step->GetStepLength();
+    if (birks <= 0.0 || length <= 0.0 || step->GetTrack()->GetDefinition()->GetPDGCharge() == 0.0) return edep;
+
+    const G4double eloss = edep - step->GetNonIonizingEnergyDeposit();
+    return eloss / (1.0 + birks * eloss / length);
+}
+
+
+void LightLUTSampler::Deposit(const G4Step *step) {
+    const auto *pre = step->GetPreStepPoint();
+    if (pre->GetMaterial() != material) ReadMaterial(pre->GetMaterial());
+
+    const G4ThreeVector mid = 0.5 * (pre->GetPosition() + step->GetPostStepPoint()->GetPosition());
+    const G4ThreeVector local = pre->GetTouchable()->GetHistory()->GetTopTransform().TransformPoint(mid);
+    Emit(VisibleEnergy(step), local, pre->GetGlobalTime());
+}
+
+
+void LightLUTSampler::Deposit(const G4Material *mat, const G4double visibleE, const G4ThreeVector &local,
+                              const G4double t) {
+    if (mat != material) ReadMaterial(mat);
+    Emit(visibleE, local, t);
+}
+
+
+void LightLUTSampler::Emit(const G4double visibleE, const G4ThreeVector &local, const G4double t) {
+    if (yield <= 0.0) return;
+
+    const G4double mean = yield * visibleE;
+    if (mean <= 0.0) return;
+
+    // Photon count as in G4Scintillation: Poisson for small means, else Gaussian widened by the resolution scale
+    G4int nPhotons;
+    if (mean > 10.0) {
+        const G4double sigma = resolution * std::sqrt(mean);
+        nPhotons = static_cast<G4int>(std::lround(std::max(0.0, G4RandGauss::shoot(mean, sigma))));
+    } else {
+        nPhotons = static_cast<G4int>(G4Poisson(mean));
+    }
+    if (nPhotons <= 0) return;
+
+    const G4int voxel = src->Voxel(local);
+    if (voxel < 0) return;
+
+    if (!sipmSD) {
+        sipmSD = dynamic_cast<SiPMOpticalSD*>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("SiPMOpticalSD", false));
+        if (!sipmSD) return;
+    }
+
+    // A photon is detected by at most one channel: multinomial counts, drawn as conditional binomials
+    const size_t nCh = src->channels.size();
+    const G4double *p = src->prob.data() + voxel * nCh;
+    G4int remaining = nPhotons;
+    G4double rest = 1.0;  // probability mass of the channels not drawn yet, including "not detected"
+    for (size_t c = 0; c < nCh && remaining > 0; ++c) {
+        if (p[c] <= 0.0) continue;
+        const G4double q = rest > p[c] ? p[c] / rest : 1.0;
+        rest -= p[c];
+        const G4int npe = static_cast<G4int>(CLHEP::RandBinomial::shoot(remaining, q));
+        if (npe <= 0) continue;
+        remaining -= npe;
+        sipmSD->AddDetected(src->channels[c].group, src->channels[c].ch, npe, t);
+    }
+}
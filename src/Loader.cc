@@ -2,6 +2,8 @@
 
 using namespace Configuration;
 
+std::vector<G4String> Split(const G4String& line);
+
 Loader::Loader(int argc, char** argv) {
     numThreads = G4Threading::G4GetNumberOfCores();
     useUI = true;
@@ -10,16 +12,38 @@ Loader::Loader(int argc, char** argv) {
     detectorType = "CsI";
     fluxType = "Uniform";
     fluxDirection = "isotropic";
+    fluxComponents.clear();
+    energyBias = "none";
+    rayCulling = false;
+    primaryBatch = 0;
+    pileupRate = 0 * hertz;
+    pileupWindow = 0 * ns;
     eCrystalThreshold = 0 * MeV;
     eVetoThreshold = 0 * MeV;
+    earlyAbort = false;
     useOptics = false;
-    yieldScale = 1;
+    photonThinning = 1;
     oCrystalThreshold = 0 * MeV;
     oVetoThreshold = 0 * MeV;
+    npeCapCrystal = 0;
+    npeCapVeto = 0;
+    npeCapBottomVeto = 0;
+    lutCalibrate = false;
+    lightLUT = false;
+    crystalFastOptics = false;
+    lutFile = "";
+    lutVoxels = 10;
+    lutPhotons = 1000;
+    photonPolicy = "";
     outputFile = "GammaCube.root";
     nBins = 1000;
     saveSecondaries = false;
+    secondariesFilter = "";
     savePhotons = false;
+    edepSchema = 1;
+    asyncOutput = false;
+    asyncBufferMB = 64;
+    outputFormat = "root";
 
     for (int i = 0; i < argc; i++) {
         if (std::string input(argv[i]); input == "-i" || input == "--input") {
@@ -28,12 +52,14 @@ Loader::Loader(int argc, char** argv) {
             viewDeg = 360 * deg;
         } else if (input == "-t" || input == "--threads") {
             numThreads = std::stoi(argv[i + 1]);
-        } else if (input == "-ys" || input == "--yield-scale") {
-            yieldScale = std::stoi(argv[i + 1]);
+        } else if (input == "-pt" || input == "--photon-thinning" || input == "-ys" || input == "--yield-scale") {
+            photonThinning = std::stod(argv[i + 1]);
         } else if (input == "--bins") {
             nBins = std::stoi(argv[i + 1]);
         } else if ((input == "-vd" || input == "--view-deg") and useUI) {
             viewDeg = std::stod(argv[i + 1]) * deg;
+        } else if (input == "--early-abort") {
+            earlyAbort = true;
         } else if (input == "-ct" || input == "--crystal-threshold") {
             eCrystalThreshold = std::stod(argv[i + 1]) * MeV;
         } else if (input == "-vt" || input == "--veto-threshold") {
@@ -44,6 +70,12 @@ Loader::Loader(int argc, char** argv) {
             oVetoThreshold = std::stoi(argv[i + 1]);
         } else if (input == "-obvt" || input == "--bottom-veto-optic-threshold") {
             oBottomVetoThreshold = std::stoi(argv[i + 1]);
+        } else if (input == "--crystal-npe-cap") {
+            npeCapCrystal = std::stod(argv[i + 1]);
+        } else if (input == "--veto-npe-cap") {
+            npeCapVeto = std::stod(argv[i + 1]);
+        } else if (input == "--bottom-veto-npe-cap") {
+            npeCapBottomVeto = std::stod(argv[i + 1]);
         } else if ((input == "-vch" || input == "--veto-chamfer-height") and Sizes::vetoTopRoundedRadius == 0) {
             Sizes::vetoChamferHeight = std::stod(argv[i + 1]) * mm;
         } else if ((input == "-vtr" || input == "--veto-top-rounded") and Sizes::vetoTopRoundedRadius == 0) {
@@ -62,12 +94,46 @@ Loader::Loader(int argc, char** argv) {
             fluxType = argv[i + 1];
         } else if (input == "--flux-dir" || input == "--f-dir" || input == "-fd") {
             fluxDirection = argv[i + 1];
+        } else if (input == "--energy-bias") {
+            energyBias = argv[i + 1];
+        } else if (input == "--ray-culling") {
+            rayCulling = true;
+        } else if (input == "--primary-batch") {
+            primaryBatch = std::stoi(argv[i + 1]);
+        } else if (input == "--pileup-rate") {
+            pileupRate = std::stod(argv[i + 1]) * hertz;
+        } else if (input == "--pileup-window") {
+            pileupWindow = std::stod(argv[i + 1]) * ns;
         } else if (input == "--use-optics") {
             useOptics = true;
+        } else if (input == "--lut-calibrate") {
+            lutCalibrate = true;
+        } else if (input == "--light-lut") {
+            lightLUT = true;
+        } else if (input == "--crystal-fast-optics") {
+            crystalFastOptics = true;
+        } else if (input == "--lut-file") {
+            lutFile = argv[i + 1];
+        } else if (input == "--lut-voxels") {
+            lutVoxels = std::stoi(argv[i + 1]);
+        } else if (input == "--lut-photons") {
+            lutPhotons = std::stoi(argv[i + 1]);
+        } else if (input == "--photon-policy") {
+            photonPolicy = argv[i + 1];
         } else if (input == "--save-secondaries") {
             saveSecondaries = true;
+        } else if (input == "--secondaries-filter") {
+            secondariesFilter = argv[i + 1];
         } else if (input == "--save-photons") {
             savePhotons = true;
+        } else if (input == "--edep-schema") {
+            edepSchema = std::stoi(argv[i + 1]);
+        } else if (input == "--async-output") {
+            asyncOutput = true;
+        } else if (input == "--async-buffer-mb") {
+            asyncBufferMB = std::stoi(argv[i + 1]);
+        } else if (input == "--format") {
+            outputFormat = argv[i + 1];
         } else if (input == "-g" || input == "--geom-config") {
             geomConfigPath = argv[i + 1];
         } else if (input == "-o" || input == "--output-file") {
@@ -76,9 +142,70 @@ Loader::Loader(int argc, char** argv) {
         }
     }
 
-    savePhotons = savePhotons and useOptics;
+    if (lutCalibrate && lightLUT) {
+        G4Exception("Loader::Loader", "LightLUT", FatalException,
+                    "--lut-calibrate writes the light-collection table that --light-lut reads: use one at a time");
+    }
+    if (crystalFastOptics && (lutCalibrate || lightLUT)) {
+        G4Exception("Loader::Loader", "LightLUT", FatalException,
+                    "--crystal-fast-optics needs optical tracking for the rest of the detector: "
+                    "it cannot be combined with --lut-calibrate or --light-lut");
+    }
+    if (!photonPolicy.empty() && (lutCalibrate || lightLUT)) {
+        G4Exception("Loader::Loader", "PhotonPolicy", FatalException,
+                    "--photon-policy kills tracked photons: it cannot be combined with the light-collection table modes");
+    }
+    if (lutCalibrate || lightLUT || crystalFastOptics) {
+        useOptics = true;
+    }
+    // The policy estimates survival from the calibrated table
+    if (lutCalibrate || lightLUT || crystalFastOptics || !photonPolicy.empty()) {
+        if (lutFile.empty()) lutFile = LightLUT::DefaultPath();
+    }
+    if (!useOptics) photonPolicy = "";
+    savePhotons = savePhotons and useOptics and !lightLUT;
+
+    // A cap at or below the threshold would change which events trigger
+    if ((npeCapCrystal > 0 && npeCapCrystal <= oCrystalThreshold) || (npeCapVeto > 0 && npeCapVeto <= oVetoThreshold)
+        || (npeCapBottomVeto > 0 && npeCapBottomVeto <= oBottomVetoThreshold)) {
+        G4Exception("Loader::Loader", "NpeCap", FatalException,
+                    "An npe cap must be above the optical threshold of its subdetector");
+    }
+    if (!useOptics || lightLUT) {
+        npeCapCrystal = npeCapVeto = npeCapBottomVeto = 0;
+    }
+
+    if (edepSchema != 1 && edepSchema != 2) {
+        G4Exception("Loader::Loader", "EdepSchema", FatalException, "--edep-schema must be 1 or 2");
+    }
+
+    if (asyncOutput && asyncBufferMB < 1) {
+        G4Exception("Loader::Loader", "AsyncOutput", FatalException, "--async-buffer-mb must be at least 1");
+    }
+
+    if (outputFormat != "root" && outputFormat != "gcev") {
+        G4Exception("Loader::Loader", "OutputFormat", FatalException, "--format must be root or gcev");
+    }
+    if (outputFormat == "gcev" && asyncOutput) {
+        G4Exception("Loader::Loader", "OutputFormat", FatalException,
+                    "--format gcev cannot be combined with --async-output");
+    }
+
+    if (photonThinning < 1) {
+        G4Exception("Loader::Loader", "PhotonThinning", FatalException,
+                    "--photon-thinning must be at least 1");
+    }
+    // The sampler reads the thinned SCINTILLATIONYIELD and RESOLUTIONSCALE but counts every p.e. with weight 1
+    if (photonThinning > 1 && (lutCalibrate || lightLUT || crystalFastOptics)) {
+        G4Exception("Loader::Loader", "PhotonThinning", FatalException,
+                    "--photon-thinning cannot be combined with the light-collection table modes "
+                    "or --crystal-fast-optics");
+    }
 
     configPath = "../Flux_config/" + fluxType + "_params.txt";
+    if (fluxType == "Composite") {
+        fluxComponents = Split(ReadValue("components:", ""));
+    }
 
     CLHEP::HepRandom::setTheEngine(new CLHEP::RanecuEngine);
     CLHEP::HepRandom::setTheSeed(time(nullptr));
@@ -96,7 +223,8 @@ Loader::Loader(int argc, char** argv) {
     physicsList->ReplacePhysics(new G4EmStandardPhysics_option4());
     physicsList->ReplacePhysics(new G4RadioactiveDecayPhysics());
 
-    if (useOptics) {
+    // With --light-lut the SiPM response comes from the table: no optical transport at all
+    if (useOptics && !lightLUT) {
         auto* opticalPhysics = new G4OpticalPhysics();
 
         auto* op = G4OpticalParameters::Instance();
@@ -116,25 +244,19 @@ Loader::Loader(int argc, char** argv) {
         physicsList->RegisterPhysics(opticalPhysics);
     }
 
+    if (crystalFastOptics) {
+        auto* fastSimulation = new G4FastSimulationPhysics();
+        fastSimulation->ActivateFastSimulation("e-");
+        physicsList->RegisterPhysics(fastSimulation);
+    }
+
     physicsList->RegisterPhysics(new G4StepLimiterPhysics());
     runManager->SetUserInitialization(physicsList);
 
     G4double EminMeV = std::max({std::stod(ReadValue("E_min:", "")) * MeV, eCrystalThreshold});
     G4double EmaxMeV = std::stod(ReadValue("E_max:", "")) * MeV;
 
-    if (fluxDirection == "isotropic") {
-        dir = FluxDir::Isotropic;
-    } else if (fluxDirection == "isotropic_up") {
-        dir = FluxDir::Isotropic_up;
-    } else if (fluxDirection == "isotropic_down") {
-        dir = FluxDir::Isotropic_down;
-    } else if (fluxDirection == "vertical_up") {
-        dir = FluxDir::Vertical_up;
-    } else if (fluxDirection == "vertical_down") {
-        dir = FluxDir::Vertical_down;
-    } else if (fluxDirection == "horizontal") {
-        dir = FluxDir::Horizontal;
-    }
+    fluxDirFromName(fluxDirection, dir);
     area = Area_cm2(Sizes::modelRadius, Sizes::modelHeight, dir);
     runManager->SetUserInitialization(new ActionInitialization(area, EminMeV, EmaxMeV));
     runManager->Initialize();
@@ -163,6 +285,9 @@ Loader::Loader(int argc, char** argv) {
         crystalOnlyOpt = cOnlyOpt;
         crystalAndVetoOpt = cAndVOpt;
         effAreaOpt = runAction->GetEffAreaOpt();
+        culled = runAction->GetCulled();
+        aborted = runAction->GetAborted();
+        speciesCounts = runAction->GetSpeciesCounts();
     }
     SaveConfig();
     RunPostProcessing();
@@ -216,11 +341,14 @@ std::vector<G4String> Split(const G4String& line) {
 
 
 void Loader::SaveConfig() const {
-    const int N = std::stoi(ReadValue("/run/beamOn", "../run.mac"));
+    // Culled primaries never became events but were drawn from the same flux
+    const long long N = std::stoll(ReadValue("/run/beamOn", "../run.mac")) + static_cast<long long>(culled);
 
     EnergyRange er{};
     FluxType fType{};
     FluxParams fp{};
+    std::vector<FluxComponent> components;
+    const bool composite = fluxType == "Composite";
 
     if (fluxType == "PLAW") {
         fType = FluxType::PLAW;
@@ -256,6 +384,18 @@ void Loader::SaveConfig() const {
         fp.table_path = ReadValue("table_path:");
         er.Emin = std::stod(ReadValue("E_min:"));
         er.Emax = std::stod(ReadValue("E_max:"));
+    } else if (fluxType == "Composite") {
+        er.Emin = std::stod(ReadValue("E_min:"));
+        er.Emax = std::stod(ReadValue("E_max:"));
+        try {
+            for (const auto& spec : fluxComponents) {
+                components.push_back(readFluxComponent(spec));
+                components.back().eRange.Emin = std::max(components.back().eRange.Emin, eCrystalThreshold / MeV);
+            }
+        }
+        catch (const std::exception& ex) {
+            components.clear();
+        }
     } else {
         fType = FluxType::UNIFORM;
         er.Emin = std::stod(ReadValue("E_min:"));
@@ -265,20 +405,36 @@ void Loader::SaveConfig() const {
     RateCounts counts{crystalOnly, crystalAndVeto};
     RateCounts countsOpt{crystalOnlyOpt, crystalAndVetoOpt};
 
+    // Stratified runs do not follow the source spectrum: only the effective-area based rates apply
+    const bool spectrumSampled = energyBias != "stratified";
+
     RateResult rr{};
-    bool rate_ok = true;
+    bool rate_ok = spectrumSampled;
     try {
-        rr = computeRate(fType, fp, er, area, N, counts);
+        if (rate_ok) {
+            rr = composite
+                     ? computeRateComposite(components, area, static_cast<double>(N), counts)
+                     : computeRate(fType, fp, er, area, static_cast<double>(N), counts);
+        }
     }
     catch (const std::exception& ex) {
         rate_ok = false;
         // G4cerr << "[SaveConfig] WARNING: Rate computation failed: " << ex.what() << G4endl;
     }
 
+    // A composite folds every species with its own effective area, not the one of the mixture
+    std::vector<std::vector<double>> speciesEffArea, speciesEffAreaOpt;
+    for (const SpeciesCounts& sc : speciesCounts) {
+        speciesEffArea.push_back(sc.effArea);
+        speciesEffAreaOpt.push_back(sc.effAreaOpt);
+    }
+
     RateResult rrReal{};
     bool rate_real_ok = true;
     try {
-        rrReal = computeRateReal(fType, fp, er, effArea, nBins);
+        rrReal = composite
+                     ? computeRateRealComposite(components, er, speciesEffArea, nBins)
+                     : computeRateReal(fType, fp, er, effArea, nBins);
     }
     catch (const std::exception& ex) {
         rate_real_ok = false;
@@ -286,9 +442,13 @@ void Loader::SaveConfig() const {
     }
 
     RateResult rr_opt{};
-    bool rate_opt_ok = useOptics;
+    bool rate_opt_ok = useOptics && spectrumSampled;
     try {
-        rr_opt = computeRate(fType, fp, er, area, N, countsOpt);
+        if (rate_opt_ok) {
+            rr_opt = composite
+                         ? computeRateComposite(components, area, static_cast<double>(N), countsOpt)
+                         : computeRate(fType, fp, er, area, static_cast<double>(N), countsOpt);
+        }
     }
     catch (const std::exception& ex) {
         rate_opt_ok = false;
@@ -298,7 +458,9 @@ void Loader::SaveConfig() const {
     RateResult rrReal_opt{};
     bool rate_real_opt_ok = useOptics;
     try {
-        rrReal_opt = computeRateReal(fType, fp, er, effAreaOpt, nBins);
+        rrReal_opt = composite
+                         ? computeRateRealComposite(components, er, speciesEffAreaOpt, nBins)
+                         : computeRateReal(fType, fp, er, effAreaOpt, nBins);
     }
     catch (const std::exception& ex) {
         rate_real_opt_ok = false;
@@ -307,13 +469,22 @@ void Loader::SaveConfig() const {
 
     std::ostringstream buf;
 
-    buf << "N: " << N << "\n\n";
+    buf << "N: " << N << "\n";
+    buf << "N_culled: " << static_cast<long long>(culled) << "\n";
+    buf << "N_aborted: " << static_cast<long long>(aborted) << "\n\n";
     buf << "Detector_type: " << detectorType << "\n";
     buf << "Crystal_SiPM_configuration: " << crystalSiPMConfig << "\n";
     buf << "Tyvek_surface: " << (polishedTyvek ? "polished" : "diffuse") << "\n\n";
-    buf << "Use_optics: " << useOptics << "\n\n";
+    buf << "Use_optics: " << useOptics << "\n";
+    buf << "Photon_thinning: " << photonThinning << "\n";
+    buf << "Light_LUT: " << (lutCalibrate ? "calibrate " : lightLUT ? "apply " : crystalFastOptics ? "crystal_fast " : "none")
+        << (lutCalibrate || lightLUT || crystalFastOptics ? lutFile : "") << "\n";
+    buf << "Photon_policy: " << (photonPolicy.empty() ? "none" : photonPolicy) << "\n\n";
     buf << "Flux_type: " << fluxType << "\n";
     buf << "Flux_dir: " << fluxDirection << "\n";
+    buf << "Energy_bias: " << energyBias << "\n";
+    buf << "Pileup_rate_Hz: " << pileupRate / hertz << "\n";
+    buf << "Pileup_window_ns: " << pileupWindow / ns << "\n";
 
     buf << "Flux_params:\n{\n\t";
     if (fluxType == "PLAW") {
@@ -336,6 +507,8 @@ void Loader::SaveConfig() const {
         buf << "particle: " << ReadValue("particle:") << "\n";
     } else if (fluxType == "Uniform") {
         buf << "fractions: " << ReadValue("fractions:") << "\n";
+    } else if (composite) {
+        buf << "components: " << ReadValue("components:") << "\n";
     }
     buf << "}\n\n";
 
@@ -348,6 +521,14 @@ void Loader::SaveConfig() const {
         buf << ReadValue("particle:");
     } else if (fluxType == "Uniform") {
         buf << ReadValue("particles:");
+    } else if (composite) {
+        for (size_t i = 0; i < components.size(); i++) {
+            const auto& c = components[i];
+            buf << (i == 0 ? "" : ", ");
+            if (c.type == FluxType::PLAW || c.type == FluxType::COMP) buf << "gamma";
+            else if (c.type == FluxType::SEP) buf << "proton";
+            else buf << c.params.particle;
+        }
     }
     buf << "]\n";
 
@@ -365,12 +546,19 @@ void Loader::SaveConfig() const {
         for (size_t i = 0; i < particles.size(); i++) {
             buf << (i == 0 ? "" : "\t") << particles[i] << ": (" << EminVec[i] << ", " << EmaxVec[i] << "),\n";
         }
+    } else if (composite) {
+        for (size_t i = 0; i < components.size(); i++) {
+            const auto& c = components[i];
+            buf << (i == 0 ? "" : "\t") << c.spec << ": (" << c.eRange.Emin << ", " << c.eRange.Emax << "),\n";
+        }
     }
-    if (fluxType != "Uniform") {
+    if (fluxType != "Uniform" && !composite) {
         buf << "(" << ReadValue("E_min:") << ", " << ReadValue("E_max:") << ")\n";
     }
     buf << "}\n\n";
 
+    // Weighted counts when the energies are biased; integers are printed exactly either way
+    buf << std::setprecision(15);
     buf << "Counts:\n{\n\t";
     buf << "Crystal_only: " << crystalOnly << "\n\t";
     buf << "Veto_then_Crystal: " << crystalAndVeto << "\n}\n\n";
@@ -396,6 +584,12 @@ void Loader::SaveConfig() const {
     }
     buf << "}\n\n";
 
+    buf << "Npe_caps:\n{\n\t";
+    buf << "Crystal: " << npeCapCrystal << "\n\t";
+    buf << "Veto: " << npeCapVeto << "\n\t";
+    buf << "BottomVeto: " << npeCapBottomVeto << "\n";
+    buf << "}\n\n";
+
     buf << "Rates:\n{\n\t";
     buf << std::fixed << std::setprecision(6);
     if (rate_ok) {
@@ -440,6 +634,58 @@ void Loader::SaveConfig() const {
     }
     buf << "}\n\n";
 
+    // Every species is a share of the same N histories, so its rate uses the Ndot of the whole mixture
+    if (composite) {
+        buf << "Species:\n{\n";
+        for (size_t i = 0; i < components.size(); i++) {
+            const SpeciesCounts sc = i < speciesCounts.size() ? speciesCounts[i] : SpeciesCounts{};
+            buf << "\t" << components[i].spec << ":\n\t{\n\t\t";
+            if (rate_ok) {
+                buf << "Fraction: " << componentIntegral(components[i]) / rr.integral << "\n\t\t";
+            } else {
+                buf << "Fraction: NaN\n\t\t";
+            }
+            buf << "Generated: " << sc.generated << "\n\t\t";
+            buf << "Crystal_only: " << sc.crystalOnly << "\n\t\t";
+            buf << "Optical_Crystal_only: " << sc.crystalOnlyOpt << "\n\t\t";
+            if (rate_ok) {
+                buf << "Rate_Crystal_only: " << sc.crystalOnly * rr.Ndot / static_cast<double>(N) << "\n\t\t";
+            } else {
+                buf << "Rate_Crystal_only: NaN\n\t\t";
+            }
+            if (rate_opt_ok) {
+                buf << "Optical_rate_Crystal_only: " << sc.crystalOnlyOpt * rr_opt.Ndot / static_cast<double>(N) << "\n\t\t";
+            } else {
+                buf << "Optical_rate_Crystal_only: NaN\n\t\t";
+            }
+            RateResult real{}, realOpt{};
+            bool real_ok = true;
+            bool real_opt_ok = useOptics;
+            try {
+                real = computeRateRealComposite({components[i]}, er, {sc.effArea}, nBins);
+            } catch (const std::exception&) {
+                real_ok = false;
+            }
+            try {
+                if (real_opt_ok) realOpt = computeRateRealComposite({components[i]}, er, {sc.effAreaOpt}, nBins);
+            } catch (const std::exception&) {
+                real_opt_ok = false;
+            }
+            if (real_ok) {
+                buf << "Rate_Real: " << real.rateRealCrystal << "\n\t\t";
+            } else {
+                buf << "Rate_Real: NaN\n\t\t";
+            }
+            if (real_opt_ok) {
+                buf << "Optical_rate_Real: " << realOpt.rateRealCrystal << "\n";
+            } else {
+                buf << "Optical_rate_Real: NaN\n";
+            }
+            buf << "\t}\n";
+        }
+        buf << "}\n\n";
+    }
+
     auto sanitize = [](std::string ss) {
         for (char& c : ss) if (c == ' ') c = '_';
         return ss;
@@ -493,13 +739,16 @@ void Loader::RunPostProcessing() const {
             part = "gamma";
         } else if (fluxType == "SEP") {
             part = "proton";
+        } else if (fluxType == "Composite") {
+            part = ReadValue("components:");
+            outDir += "_components:" + part;
         }
         outDir = sanitize(outDir);
         PostProcessing postProcessing(outDir, Emin, Emax, part);
 
         postProcessing.ExtractNtData();
         if (Emin < Emax) {
-            if (fluxDirection.find("isotropic") != std::string::npos)
+            if (isIsotropic(dir))
                 postProcessing.SaveSensitivity();
             else
                 postProcessing.SaveEffArea();
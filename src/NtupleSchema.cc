@@ -0,0 +1,54 @@
+#include "NtupleSchema.hh"
+
+#include <G4Exception.hh>
+#include <algorithm>
+
+
+NtupleSchema &NtupleSchema::Instance() {
+    static NtupleSchema instance;
+    return instance;
+}
+
+
+G4int NtupleSchema::CreateTable(const G4String &name, const G4String &title) {
+    G4AutoLock lock(&mutex);
+    for (size_t t = 0; t < tables.size(); ++t) {
+        if (tables[t].name == name) return static_cast<G4int>(t);
+    }
+    tables.push_back({name, title, {}, true});
+    return static_cast<G4int>(tables.size() - 1);
+}
+
+
+void NtupleSchema::AddColumn(const G4int table, const char type, const G4String &name) {
+    G4AutoLock lock(&mutex);
+    Table &t = tables[table];
+    if (!t.open) return;
+    if (t.columns.size() == static_cast<size_t>(maxColumns)) {
+        G4Exception("NtupleSchema::AddColumn", "NtupleSchema", FatalException,
+                    ("too many columns in " + t.name).c_str());
+    }
+    if (type == 'S' && std::any_of(t.columns.begin(), t.columns.end(), [](const Column &c) { return c.type == 'S'; })) {
+        G4Exception("NtupleSchema::AddColumn", "NtupleSchema", FatalException,
+                    ("a second string column in " + t.name).c_str());
+    }
+    t.columns.push_back({type, name});
+}
+
+
+void NtupleSchema::FinishTable(const G4int table) {
+    G4AutoLock lock(&mutex);
+    tables[table].open = false;
+}
+
+
+std::vector<NtupleSchema::Table> NtupleSchema::Tables() const {
+    G4AutoLock lock(&mutex);
+    return tables;
+}
+
+
+NtupleSchema::Table NtupleSchema::GetTable(const G4int table) const {
+    G4AutoLock lock(&mutex);
+    return tables[table];
+}
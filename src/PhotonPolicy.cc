@@ -0,0 +1,127 @@
+#include "PhotonPolicy.hh"
+
+#include <fstream>
+#include <unordered_map>
+
+#include "Configuration.hh"
+#include "SiPMOpticalSD.hh"
+#include "Utils.hh"
+
+
+PhotonPolicy::PhotonPolicy(const G4String &path) {
+    if (path.empty()) return;
+
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        G4Exception("PhotonPolicy::PhotonPolicy", "FILE_OPEN_FAIL", FatalException,
+                    ("Cannot open photon policy " + path).c_str());
+        return;
+    }
+
+    std::unordered_map<std::string, G4String> spec;
+    G4String line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        const size_t pos = line.find(':');
+        if (pos == G4String::npos) continue;
+        const G4String key = Utils::Trim(line.substr(0, pos));
+        const G4String val = Utils::Trim(line.substr(pos + 1));
+        if (!key.empty() && !val.empty()) spec[key] = val;
+    }
+
+    // Prefixed keys first, then the unprefixed default
+    auto value = [&spec](const G4String &origin, const G4String &key) -> const G4String * {
+        if (const auto it = spec.find(origin + "." + key); it != spec.end()) return &it->second;
+        if (const auto it = spec.find(key); it != spec.end()) return &it->second;
+        return nullptr;
+    };
+
+    try {
+        for (G4int o = 0; o < nOrigins; ++o) {
+            auto &lim = limits[o];
+            if (const auto *v = value(OriginName[o], "max_bounces")) lim.maxBounces = std::stoi(*v);
+            if (const auto *v = value(OriginName[o], "max_path")) lim.maxPath = std::stod(*v) * mm;
+            if (const auto *v = value(OriginName[o], "max_time")) lim.maxTime = std::stod(*v) * ns;
+            if (const auto *v = value(OriginName[o], "min_survival")) lim.minSurvival = std::stod(*v);
+        }
+    } catch (const std::exception &e) {
+        G4Exception("PhotonPolicy::PhotonPolicy", "BAD_CONFIG", FatalException,
+                    ("Bad value in " + path + ": " + e.what()).c_str());
+    }
+    active = true;
+
+    lut = LightLUT::Shared(Configuration::lutFile);
+    if (!lut) return;
+    for (G4int s = 0; s < LightLUT::nSources; ++s) {
+        const auto &src = lut->sources[s];
+        const size_t nCh = src.channels.size();
+        survival[s].assign(src.NVoxels(), {0, 0, 0});
+        for (G4int v = 0; v < src.NVoxels(); ++v) {
+            for (size_t c = 0; c < nCh; ++c) {
+                const G4int g = static_cast<G4int>(src.channels[c].group) - static_cast<G4int>(SiPMGroup::Crystal);
+                if (g >= 0 && g < 3) survival[s][v][g] += src.prob[v * nCh + c];
+            }
+        }
+    }
+}
+
+
+void PhotonPolicy::Resolve() {
+    auto *store = G4PhysicalVolumeStore::GetInstance();
+    for (G4int s = 0; s < LightLUT::nSources; ++s) sourcePV[s] = store->GetVolume(LightLUT::SourcePV[s], false);
+    resolved = true;
+}
+
+
+G4int PhotonPolicy::Source(const G4VPhysicalVolume *pv) const {
+    if (!pv) return -1;
+    for (G4int s = 0; s < LightLUT::nSources; ++s) {
+        if (pv == sourcePV[s]) return s;
+    }
+    return -1;
+}
+
+
+G4bool PhotonPolicy::Apply(const G4Step *step, PhotonLoss &loss) {
+    G4Track *track = step->GetTrack();
+    // Detected or absorbed in this step: the SD and the processes have already had their say
+    if (track->GetTrackStatus() != fAlive) return false;
+    if (!resolved) Resolve();
+
+    const auto *pre = step->GetPreStepPoint();
+    const G4int source = Source(pre->GetPhysicalVolume());
+
+    if (track->GetCurrentStepNumber() == 1) {
+        // Sources are in PhotonOrigin order, anything else is Other
+        origin = source >= 0 ? source : nOrigins - 1;
+        bounces = 0;
+        estimate = {0, 0, 0};
+        estimated = false;
+    }
+    if (step->GetPostStepPoint()->GetStepStatus() == fGeomBoundary) ++bounces;
+
+    // The estimate follows the photon through the scintillators and is kept while it is outside them
+    if (source >= 0 && !survival[source].empty()) {
+        const G4ThreeVector local = pre->GetTouchable()->GetHistory()->GetTopTransform()
+                                       .TransformPoint(pre->GetPosition());
+        const G4int voxel = lut->sources[source].Voxel(local);
+        if (voxel >= 0) {
+            estimate = survival[source][voxel];
+            estimated = true;
+        }
+    }
+
+    const Limits &lim = limits[origin];
+    const G4double pDetect = estimate[0] + estimate[1] + estimate[2];
+    const G4bool kill = (lim.maxBounces >= 0 && bounces > lim.maxBounces)
+                        || (lim.maxPath >= 0 && track->GetTrackLength() > lim.maxPath)
+                        || (lim.maxTime >= 0 && track->GetGlobalTime() > lim.maxTime)
+                        || (lim.minSurvival > 0 && estimated && pDetect < lim.minSurvival);
+    if (!kill) return false;
+
+    track->SetTrackStatus(fStopAndKill);
+    const G4double w = track->GetWeight();
+    loss.killed += w;
+    for (size_t g = 0; g < 3; ++g) loss.npe[g] += w * estimate[g];
+    return true;
+}
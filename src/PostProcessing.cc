@@ -26,6 +26,170 @@ void PostProcessing::OpenRootFile() {
     if (!rootFile || rootFile->IsZombie()) {
         throw std::runtime_error("Failed to open ROOT file: " + outputFile);
     }
+    if (asyncOutput) {
+        const std::string rowsFile = AsyncWriter::PathFor(outputFile);
+        asyncFile.reset(TFile::Open(rowsFile.c_str(), "READ"));
+        if (!asyncFile || asyncFile->IsZombie()) {
+            throw std::runtime_error("Failed to open ROOT file: " + rowsFile);
+        }
+    }
+    if (outputFormat == "gcev") {
+        gcevStore = std::make_unique<GcevReader>(GcevStore::DirFor(outputFile));
+    }
+}
+
+TTree* PostProcessing::GetTree(const std::string& treeName) {
+    TTree* tree = nullptr;
+    rootFile->GetObject(treeName.c_str(), tree);
+    if (!tree && asyncFile) asyncFile->GetObject(treeName.c_str(), tree);
+    return tree;
+}
+
+double PostProcessing::ScanRow::Real(const size_t k) const {
+    const Field& f = fields[k];
+    if (f.kind == 'D') {
+        double v;
+        std::memcpy(&v, f.data + row * sizeof(v), sizeof(v));
+        return v;
+    }
+    if (f.kind == 'F') {
+        float v;
+        std::memcpy(&v, f.data + row * sizeof(v), sizeof(v));
+        return v;
+    }
+    return Int(k);
+}
+
+Int_t PostProcessing::ScanRow::Int(const size_t k) const {
+    const Field& f = fields[k];
+    if (f.kind == 'D' || f.kind == 'F') return static_cast<Int_t>(Real(k));
+    Int_t v;
+    std::memcpy(&v, f.data + row * sizeof(v), sizeof(v));
+    return v;
+}
+
+const char* PostProcessing::ScanRow::Text(const size_t k) const {
+    const Field& f = fields[k];
+    if (f.kind == 'S') return f.dictionary->at(Int(k)).c_str();
+    return f.text;
+}
+
+bool PostProcessing::ScanRows(const std::string& treeName,
+                              const std::vector<std::string>& names,
+                              const std::function<void(const ScanRow&)>& fn) {
+    ScanRow row;
+    row.fields.resize(names.size());
+
+    if (const GcevReader::Table* table = gcevStore ? gcevStore->Find(treeName) : nullptr) {
+        std::vector<size_t> cols(names.size());
+        for (size_t k = 0; k < names.size(); ++k) {
+            const auto& columns = table->columns;
+            const auto it = std::find_if(columns.begin(), columns.end(), [&](const GcevReader::Column& c) {
+                return c.name == names[k];
+            });
+            if (it == columns.end()) {
+                throw std::runtime_error("Column not found: " + treeName + "." + names[k]);
+            }
+            cols[k] = static_cast<size_t>(it - columns.begin());
+            ScanRow::Field& f = row.fields[k];
+            f.kind = it->encoded ? 'S' : it->type == "f8" ? 'D' : it->type == "f4" ? 'F' : 'I';
+            f.dictionary = &it->dictionary;
+        }
+        for (size_t s = 0; s < table->segments.size(); ++s) {
+            const size_t rows = table->segments[s].rows;
+            if (rows == 0) continue;
+            for (size_t k = 0; k < names.size(); ++k) {
+                row.fields[k].data = static_cast<const char*>(gcevStore->Map(*table, cols[k], s));
+            }
+            for (row.row = 0; row.row < rows; ++row.row) fn(row);
+        }
+        return true;
+    }
+
+    TTree* tree = GetTree(treeName);
+    if (!tree) return false;
+
+    // Every branch is read into its field's 8-byte slot, a string into its text
+    tree->SetBranchStatus("*", false);
+    for (size_t k = 0; k < names.size(); ++k) {
+        const TLeaf* leaf = tree->GetLeaf(names[k].c_str());
+        if (!leaf) {
+            tree->SetBranchStatus("*", true);
+            throw std::runtime_error("Column not found: " + treeName + "." + names[k]);
+        }
+        const std::string type = leaf->GetTypeName();
+        ScanRow::Field& f = row.fields[k];
+        tree->SetBranchStatus(names[k].c_str(), true);
+        if (type == "Char_t") {
+            f.kind = 'C';
+            tree->SetBranchAddress(names[k].c_str(), static_cast<void*>(f.text));
+        } else {
+            f.kind = type == "Double_t" ? 'D' : type == "Float_t" ? 'F' : 'I';
+            f.data = reinterpret_cast<const char*>(&f.slot);
+            tree->SetBranchAddress(names[k].c_str(), static_cast<void*>(&f.slot));
+        }
+    }
+
+    const Long64_t n = tree->GetEntries();
+    for (Long64_t i = 0; i < n; ++i) {
+        tree->GetEntry(i);
+        fn(row);
+    }
+
+    // The slots go away with row
+    tree->ResetBranchAddresses();
+    tree->SetBranchStatus("*", true);
+    return true;
+}
+
+bool PostProcessing::ExportGcevToCsv(const std::string& treeName, const std::string& csvPath) {
+    const GcevReader::Table* table = gcevStore->Find(treeName);
+    if (!table) return false;
+
+    std::ofstream out(csvPath);
+    if (!out.is_open()) {
+        throw std::runtime_error("Cannot open output CSV: " + csvPath);
+    }
+
+    const size_t nCols = table->columns.size();
+    for (size_t c = 0; c < nCols; ++c) {
+        out << table->columns[c].name;
+        if (c + 1 != nCols) out << ",";
+    }
+    out << "\n";
+
+    out << std::setprecision(17);
+    std::vector<const char*> data(nCols);
+    for (size_t s = 0; s < table->segments.size(); ++s) {
+        const size_t rows = table->segments[s].rows;
+        if (rows == 0) continue;
+        for (size_t c = 0; c < nCols; ++c) data[c] = static_cast<const char*>(gcevStore->Map(*table, c, s));
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < nCols; ++c) {
+                const GcevReader::Column& col = table->columns[c];
+                const char* p = data[c] + r * col.Width();
+                if (col.type == "f8") {
+                    double v;
+                    std::memcpy(&v, p, sizeof(v));
+                    out << v;
+                } else if (col.type == "f4") {
+                    float v;
+                    std::memcpy(&v, p, sizeof(v));
+                    out << static_cast<double>(v);
+                } else {
+                    Int_t v;
+                    std::memcpy(&v, p, sizeof(v));
+                    if (col.encoded) out << col.dictionary.at(v);
+                    else out << v;
+                }
+                if (c + 1 != nCols) out << ",";
+            }
+            out << "\n";
+        }
+    }
+
+    out.close();
+    return true;
 }
 
 void PostProcessing::PrepareOutputDirs() {
@@ -72,6 +236,14 @@ double PostProcessing::EffAreaErrFromCounts(double n0, double n, double effArea)
     return effArea * std::sqrt(val);
 }
 
+// (sum w)^2 / sum w^2: the number of unweighted events with the same relative error
+double PostProcessing::EffectiveCount(const TH1* h, const int bin) {
+    const double sumW = h->GetBinContent(bin);
+    const double err = h->GetBinError(bin);
+    if (sumW <= 0.0 || err <= 0.0) return sumW;
+    return sumW * sumW / (err * err);
+}
+
 static short GetColorForParticle(const std::string& particleName) {
     if (particleName == "gamma") return kGreen + 2;
     if (particleName == "e-") return kOrange + 7;
@@ -126,8 +298,9 @@ void PostProcessing::SaveHistPng(const std::string& histName,
 
 void PostProcessing::ExportTreeToCsv(const std::string& treeName,
                                      const std::string& csvPath) {
-    TTree* tree = nullptr;
-    rootFile->GetObject(treeName.c_str(), tree);
+    if (gcevStore && ExportGcevToCsv(treeName, csvPath)) return;
+
+    TTree* tree = GetTree(treeName);
     if (!tree) {
         throw std::runtime_error("TTree/NTuple not found: " + treeName);
     }
@@ -209,12 +382,17 @@ void PostProcessing::ExportTreeToCsv(const std::string& treeName,
 void PostProcessing::ExtractNtData() {
     fs::create_directories(csvDir);
 
-    ExportTreeToCsv("edep", (fs::path(csvDir) / "edep.csv").string());
+    if (edepSchema == 2) {
+        ExportTreeToCsv("event_summary", (fs::path(csvDir) / "event_summary.csv").string());
+    } else {
+        ExportTreeToCsv("edep", (fs::path(csvDir) / "edep.csv").string());
+    }
     ExportTreeToCsv("primary", (fs::path(csvDir) / "primary.csv").string());
 
     if (saveSecondaries) {
         ExportTreeToCsv("event", (fs::path(csvDir) / "event.csv").string());
         ExportTreeToCsv("interactions", (fs::path(csvDir) / "interactions.csv").string());
+        ExportTreeToCsv("dictionary", (fs::path(csvDir) / "dictionary.csv").string());
     }
 
     if (useOptics) {
@@ -285,8 +463,9 @@ void PostProcessing::SaveEffArea() {
 
         double aeff = effArea->GetBinContent(i);
         double aeffOpt = effAreaOpt->GetBinContent(i);
-        double aeffErr = EffAreaErrFromCounts(n0, n, aeff);
-        double aeffErrOpt = EffAreaErrFromCounts(n0, nOpt, aeffOpt);
+        const double n0Eff = EffectiveCount(gen, i);
+        double aeffErr = EffAreaErrFromCounts(n0Eff, EffectiveCount(trig, i), aeff);
+        double aeffErrOpt = EffAreaErrFromCounts(n0Eff, EffectiveCount(trigOpt, i), aeffOpt);
 
         if (!useOptics) {
             nOpt = aeffOpt = aeffErrOpt = 0;
@@ -381,52 +560,67 @@ void PostProcessing::SaveSensitivity() {
     out.close();
 }
 
-void PostProcessing::SaveTrigEdepCsv() {
-    TTree* primary = nullptr;
-    rootFile->GetObject("primary", primary);
-    if (!primary) {
-        throw std::runtime_error("TTree not found: primary");
-    }
+const std::vector<PostProcessing::EventSummary>& PostProcessing::ReadEventSummary() {
+    if (eventSummaryRead) return eventSummary;
 
-    Int_t eventID_p = 0;
-    double E0 = 0.0;
+    eventSummary.clear();
+    if (!ScanRows("event_summary",
+                  {"eventID", "E0_MeV", "edep_crystal_MeV", "edep_veto_MeV", "edep_bottom_veto_MeV", "trigger"},
+                  [&](const ScanRow& row) {
+        eventSummary.push_back({row.Int(0), row.Real(1), row.Real(2), row.Real(3), row.Real(4), row.Int(5)});
+    })) {
+        throw std::runtime_error("TTree not found: event_summary");
+    }
 
-    primary->SetBranchStatus("*", false);
-    primary->SetBranchStatus("eventID", true);
-    primary->SetBranchStatus("E_MeV", true);
+    // Merged worker ntuples are not in event order
+    std::sort(eventSummary.begin(), eventSummary.end(), [](const EventSummary& a, const EventSummary& b) {
+        return a.eventID < b.eventID;
+    });
+    eventSummaryRead = true;
+    return eventSummary;
+}
 
-    primary->SetBranchAddress("eventID", &eventID_p);
-    primary->SetBranchAddress("E_MeV", &E0);
 
-    std::unordered_map<int, double> e0ByEvent;
-    e0ByEvent.reserve(std::max<Long64_t>(1, primary->GetEntries()));
+const PostProcessing::EventSummary* PostProcessing::FindEventSummary(const Int_t eventID) {
+    const std::vector<EventSummary>& rows = ReadEventSummary();
+    const auto it = std::lower_bound(rows.begin(), rows.end(), eventID, [](const EventSummary& row, const Int_t id) {
+        return row.eventID < id;
+    });
+    return it != rows.end() && it->eventID == eventID ? &*it : nullptr;
+}
 
-    const Long64_t nP = primary->GetEntries();
-    for (Long64_t i = 0; i < nP; ++i) {
-        primary->GetEntry(i);
-        e0ByEvent[eventID_p] = E0;
-    }
 
-    TTree* edep = nullptr;
-    rootFile->GetObject("edep", edep);
-    if (!edep) {
-        throw std::runtime_error("TTree not found: edep");
+std::unordered_map<int, double> PostProcessing::ReadPrimaryE0() {
+    // With --pileup-rate an event has the leading primary first and its background after it
+    std::unordered_map<int, double> e0ByEvent;
+    if (!ScanRows("primary", {"eventID", "E_MeV"}, [&](const ScanRow& row) {
+        e0ByEvent.emplace(row.Int(0), row.Real(1));
+    })) {
+        throw std::runtime_error("TTree not found: primary");
     }
+    return e0ByEvent;
+}
 
-    Int_t eventID_e = 0;
-
-    Char_t det_name[64] = {};
 
-    double edep_MeV = 0.0;
+void PostProcessing::SaveTrigEdepCsv() {
+    if (edepSchema == 2) {
+        const std::string outPath = (fs::path(histogramsDir) / "trig_edep.csv").string();
+        std::ofstream out(outPath);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open output CSV: " + outPath);
+        }
 
-    edep->SetBranchStatus("*", false);
-    edep->SetBranchStatus("eventID", true);
-    edep->SetBranchStatus("det_name", true);
-    edep->SetBranchStatus("edep_MeV", true);
+        out << "eventID,E0,Crystal_only_edep\n";
+        out << std::setprecision(17);
+        for (const auto& row : ReadEventSummary()) {
+            const double crystal_only = row.crystal > 0.0 && row.veto + row.bottomVeto == 0.0 ? row.crystal : 0.0;
+            out << row.eventID << "," << row.E0 << "," << crystal_only << "\n";
+        }
+        out.close();
+        return;
+    }
 
-    edep->SetBranchAddress("eventID", &eventID_e);
-    edep->SetBranchAddress("det_name", det_name);
-    edep->SetBranchAddress("edep_MeV", &edep_MeV);
+    std::unordered_map<int, double> e0ByEvent = ReadPrimaryE0();
 
     struct Agg {
         double crystal = 0.0;
@@ -435,13 +629,10 @@ void PostProcessing::SaveTrigEdepCsv() {
     };
 
     std::unordered_map<int, Agg> agg;
-    agg.reserve(std::max<Long64_t>(1, edep->GetEntries()));
-
-    const Long64_t nE = edep->GetEntries();
-    for (Long64_t i = 0; i < nE; ++i) {
-        edep->GetEntry(i);
-
-        auto& a = agg[eventID_e];
+    if (!ScanRows("edep", {"eventID", "det_name", "edep_MeV"}, [&](const ScanRow& row) {
+        auto& a = agg[row.Int(0)];
+        const char* det_name = row.Text(1);
+        const double edep_MeV = row.Real(2);
 
         if (std::strcmp(det_name, "Crystal") == 0) {
             a.crystal += edep_MeV;
@@ -450,6 +641,8 @@ void PostProcessing::SaveTrigEdepCsv() {
         } else if (std::strcmp(det_name, "BottomVeto") == 0) {
             a.bottomVeto += edep_MeV;
         }
+    })) {
+        throw std::runtime_error("TTree not found: edep");
     }
 
     const std::string outPath = (fs::path(histogramsDir) / "trig_edep.csv").string();
@@ -489,49 +682,31 @@ void PostProcessing::SaveTrigEdepCsv() {
 
 
 void PostProcessing::SaveEdepCsv() {
-    TTree* primary = nullptr;
-    rootFile->GetObject("primary", primary);
-    if (!primary) {
-        throw std::runtime_error("TTree not found: primary");
-    }
-
-    Int_t eventID_p = 0;
-    double E0 = 0.0;
-
-    primary->SetBranchStatus("*", false);
-    primary->SetBranchStatus("eventID", true);
-    primary->SetBranchStatus("E_MeV", true);
-
-    primary->SetBranchAddress("eventID", &eventID_p);
-    primary->SetBranchAddress("E_MeV", &E0);
-
-    std::unordered_map<int, double> e0ByEvent;
-    e0ByEvent.reserve(std::max<Long64_t>(1, primary->GetEntries()));
-
-    const Long64_t nP = primary->GetEntries();
-    for (Long64_t i = 0; i < nP; ++i) {
-        primary->GetEntry(i);
-        e0ByEvent[eventID_p] = E0;
-    }
+    if (edepSchema == 2) {
+        const std::string outPath = (fs::path(histogramsDir) / "edep.csv").string();
+        std::ofstream out(outPath);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open output CSV: " + outPath);
+        }
 
-    TTree* edep = nullptr;
-    rootFile->GetObject("edep", edep);
-    if (!edep) {
-        throw std::runtime_error("TTree not found: edep");
+        out << "eventID,E0_MeV,Trigger,Crystal_edep_MeV,Veto_edep_MeV,BottomVeto_edep_MeV\n";
+        out << std::setprecision(17);
+        for (const auto& row : ReadEventSummary()) {
+            // Schema 1 has edep rows only for events with a deposit over threshold
+            if (row.crystal + row.veto + row.bottomVeto == 0.0) continue;
+            const int trigger = (row.trigger & 1) && !(row.trigger & 2) ? 1 : 0;
+            out << row.eventID << ","
+                << row.E0 << ","
+                << trigger << ","
+                << row.crystal << ","
+                << row.veto << ","
+                << row.bottomVeto << "\n";
+        }
+        out.close();
+        return;
     }
 
-    Int_t eventID_e = 0;
-    Char_t det_name[64] = {};
-    double edep_MeV = 0.0;
-
-    edep->SetBranchStatus("*", false);
-    edep->SetBranchStatus("eventID", true);
-    edep->SetBranchStatus("det_name", true);
-    edep->SetBranchStatus("edep_MeV", true);
-
-    edep->SetBranchAddress("eventID", &eventID_e);
-    edep->SetBranchAddress("det_name", det_name);
-    edep->SetBranchAddress("edep_MeV", &edep_MeV);
+    std::unordered_map<int, double> e0ByEvent = ReadPrimaryE0();
 
     struct DetectorEdep {
         double crystal = 0.0;
@@ -540,13 +715,10 @@ void PostProcessing::SaveEdepCsv() {
     };
 
     std::unordered_map<int, DetectorEdep> edepMap;
-    edepMap.reserve(std::max<Long64_t>(1, edep->GetEntries()));
-
-    const Long64_t nEntries = edep->GetEntries();
-    for (Long64_t i = 0; i < nEntries; ++i) {
-        edep->GetEntry(i);
-
-        auto& deps = edepMap[eventID_e];
+    if (!ScanRows("edep", {"eventID", "det_name", "edep_MeV"}, [&](const ScanRow& row) {
+        auto& deps = edepMap[row.Int(0)];
+        const char* det_name = row.Text(1);
+        const double edep_MeV = row.Real(2);
 
         if (std::strcmp(det_name, "Crystal") == 0) {
             deps.crystal += edep_MeV;
@@ -555,6 +727,8 @@ void PostProcessing::SaveEdepCsv() {
         } else if (std::strcmp(det_name, "BottomVeto") == 0) {
             deps.bottomVeto += edep_MeV;
         }
+    })) {
+        throw std::runtime_error("TTree not found: edep");
     }
 
     const std::string outPath = (fs::path(histogramsDir) / "edep.csv").string();
@@ -594,49 +768,15 @@ void PostProcessing::SaveEdepCsv() {
 }
 
 void PostProcessing::SaveOpticsCsv() {
-    TTree* primary = nullptr;
-    rootFile->GetObject("primary", primary);
-    if (!primary) {
-        throw std::runtime_error("TTree not found: primary");
-    }
-
-    Int_t eventID_p = 0;
-    double E0 = 0.0;
-
-    primary->SetBranchStatus("*", false);
-    primary->SetBranchStatus("eventID", true);
-    primary->SetBranchStatus("E_MeV", true);
-
-    primary->SetBranchAddress("eventID", &eventID_p);
-    primary->SetBranchAddress("E_MeV", &E0);
-
-    std::unordered_map<int, double> e0ByEvent;
-    e0ByEvent.reserve(std::max<Long64_t>(1, primary->GetEntries()));
-
-    const Long64_t nP = primary->GetEntries();
-    for (Long64_t i = 0; i < nP; ++i) {
-        primary->GetEntry(i);
-        e0ByEvent[eventID_p] = E0;
-    }
+    std::unordered_map<int, double> e0ByEvent = ReadPrimaryE0();
 
     std::string opticDir = (fs::path(runDir) / "optic").string();
     fs::create_directories(opticDir);
 
+    // Schema 2 looks the trigger up in the sorted event_summary rows instead
     std::unordered_map<int, int> edepTriggerMap;
 
-    TTree* edep = nullptr;
-    rootFile->GetObject("edep", edep);
-    if (edep) {
-        Int_t eventID_e = 0;
-        Char_t det_name[64] = {};
-        double edep_MeV = 0.0;
-
-        edep->SetBranchStatus("*", true);
-
-        edep->SetBranchAddress("eventID", &eventID_e);
-        edep->SetBranchAddress("det_name", det_name);
-        edep->SetBranchAddress("edep_MeV", &edep_MeV);
-
+    if (edepSchema != 2) {
         struct DetectorEdep {
             double crystal = 0.0;
             double veto = 0.0;
@@ -644,11 +784,10 @@ void PostProcessing::SaveOpticsCsv() {
         };
 
         std::unordered_map<int, DetectorEdep> edepMap;
-        const Long64_t nEntries = edep->GetEntries();
-        for (Long64_t i = 0; i < nEntries; ++i) {
-            edep->GetEntry(i);
-
-            auto& deps = edepMap[eventID_e];
+        ScanRows("edep", {"eventID", "det_name", "edep_MeV"}, [&](const ScanRow& row) {
+            auto& deps = edepMap[row.Int(0)];
+            const char* det_name = row.Text(1);
+            const double edep_MeV = row.Real(2);
 
             if (std::strcmp(det_name, "Crystal") == 0) {
                 deps.crystal += edep_MeV;
@@ -657,72 +796,43 @@ void PostProcessing::SaveOpticsCsv() {
             } else if (std::strcmp(det_name, "BottomVeto") == 0) {
                 deps.bottomVeto += edep_MeV;
             }
-        }
+        });
 
         for (const auto& [evtID, deps] : edepMap) {
             edepTriggerMap[evtID] = deps.crystal > 0.0 && deps.veto == 0.0 && deps.bottomVeto == 0.0 ? 1 : 0;
         }
     }
 
-    TTree* sipmEvent = nullptr;
-    rootFile->GetObject("sipm_event", sipmEvent);
-    if (!sipmEvent) {
-        throw std::runtime_error("TTree not found: sipm_event");
-    }
-
-    Int_t eventID = 0;
-    Int_t npe_crystal = 0;
-    Int_t npe_veto = 0;
-    Int_t npe_bottom_veto = 0;
-
-    sipmEvent->SetBranchStatus("*", true);
-
-    sipmEvent->SetBranchAddress("eventID", &eventID);
-    sipmEvent->SetBranchAddress("npe_crystal", &npe_crystal);
-    sipmEvent->SetBranchAddress("npe_veto", &npe_veto);
-    sipmEvent->SetBranchAddress("npe_bottom_veto", &npe_bottom_veto);
-
     struct EventInfo {
-        Int_t crystal_npe = 0;
-        Int_t veto_npe = 0;
-        Int_t bottom_veto_npe = 0;
+        Double_t crystal_npe = 0;
+        Double_t crystal_npe_var = 0;
+        Double_t veto_npe = 0;
+        Double_t bottom_veto_npe = 0;
         Int_t trigger = 0;
     };
 
     std::unordered_map<Int_t, EventInfo> eventMap;
-    eventMap.reserve(std::max<Long64_t>(1, sipmEvent->GetEntries()));
-
-    const Long64_t nEvents = sipmEvent->GetEntries();
-    for (Long64_t i = 0; i < nEvents; ++i) {
-        sipmEvent->GetEntry(i);
+    if (!ScanRows("sipm_event", {"eventID", "npe_crystal", "npe_veto", "npe_bottom_veto", "npe_var_crystal"},
+                  [&](const ScanRow& row) {
+        const Int_t eventID = row.Int(0);
+        const Double_t npe_crystal = row.Real(1);
+        const Double_t npe_veto = row.Real(2);
+        const Double_t npe_bottom_veto = row.Real(3);
+        const Double_t npe_var_crystal = row.Real(4);
 
         EventInfo info;
         info.crystal_npe = npe_crystal;
+        info.crystal_npe_var = npe_var_crystal;
         info.veto_npe = npe_veto;
         info.bottom_veto_npe = npe_bottom_veto;
         info.trigger = npe_crystal > 0 && npe_veto + npe_bottom_veto == 0 ? 1 : 0;
 
         eventMap[eventID] = info;
+    })) {
+        throw std::runtime_error("TTree not found: sipm_event");
     }
 
-    TTree* sipmCh = nullptr;
-    rootFile->GetObject("sipm_ch", sipmCh);
-    if (!sipmCh) {
-        throw std::runtime_error("TTree not found: sipm_ch");
-    }
-
-    Int_t ch_eventID = 0;
-    char subdet[64] = {};
-    Int_t ch = 0;
-    Int_t npe = 0;
-
-    sipmCh->SetBranchStatus("*", true);
-    sipmCh->SetBranchAddress("eventID", &ch_eventID);
-    sipmCh->SetBranchAddress("subdet", subdet);
-    sipmCh->SetBranchAddress("ch", &ch);
-    sipmCh->SetBranchAddress("npe", &npe);
-
-    using ChannelMap = std::unordered_map<Int_t, std::unordered_map<Int_t, Int_t>>;
+    using ChannelMap = std::unordered_map<Int_t, std::unordered_map<Int_t, Double_t>>;
     ChannelMap crystalChannels;
     ChannelMap vetoChannels;
     ChannelMap bottomVetoChannels;
@@ -731,11 +841,11 @@ void PostProcessing::SaveOpticsCsv() {
     std::set<Int_t> allVetoChannels;
     std::set<Int_t> allBottomVetoChannels;
 
-    const Long64_t nChEntries = sipmCh->GetEntries();
-    for (Long64_t i = 0; i < nChEntries; ++i) {
-        sipmCh->GetEntry(i);
-
-        std::string subdetStr(subdet);
+    if (!ScanRows("sipm_ch", {"eventID", "subdet", "ch", "npe"}, [&](const ScanRow& row) {
+        const Int_t ch_eventID = row.Int(0);
+        const std::string subdetStr(row.Text(1));
+        const Int_t ch = row.Int(2);
+        const Double_t npe = row.Real(3);
 
         if (subdetStr == "Crystal") {
             crystalChannels[ch_eventID][ch] = npe;
@@ -747,6 +857,8 @@ void PostProcessing::SaveOpticsCsv() {
             bottomVetoChannels[ch_eventID][ch] = npe;
             allBottomVetoChannels.insert(ch);
         }
+    })) {
+        throw std::runtime_error("TTree not found: sipm_ch");
     }
 
     std::vector sortedCrystalChannels(allCrystalChannels.begin(), allCrystalChannels.end());
@@ -762,7 +874,7 @@ void PostProcessing::SaveOpticsCsv() {
         throw std::runtime_error("Cannot open output CSV: trig_opt.csv");
     }
 
-    trigOptFile << "eventID,E0_MeV,trigger_opt,trigger_edep,Crystal_npe,Veto_npe,BottomVeto_npe\n";
+    trigOptFile << "eventID,E0_MeV,trigger_opt,trigger_edep,Crystal_npe,Crystal_npe_var,Veto_npe,BottomVeto_npe\n";
 
     std::vector<Int_t> allEventIDs;
     allEventIDs.reserve(eventMap.size());
@@ -775,8 +887,11 @@ void PostProcessing::SaveOpticsCsv() {
         const auto& info = eventMap[evtID];
 
         int trigger_edep = 0;
-        auto it = edepTriggerMap.find(evtID);
-        if (it != edepTriggerMap.end()) {
+        if (edepSchema == 2) {
+            if (const EventSummary* row = FindEventSummary(evtID)) {
+                trigger_edep = (row->trigger & 1) && !(row->trigger & 2) ? 1 : 0;
+            }
+        } else if (auto it = edepTriggerMap.find(evtID); it != edepTriggerMap.end()) {
             trigger_edep = it->second;
         }
 
@@ -785,6 +900,7 @@ void PostProcessing::SaveOpticsCsv() {
             << info.trigger << ","
             << trigger_edep << ","
             << info.crystal_npe << ","
+            << info.crystal_npe_var << ","
             << info.veto_npe << ","
             << info.bottom_veto_npe << "\n";
     }
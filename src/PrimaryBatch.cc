@@ -0,0 +1,163 @@
+#include "PrimaryBatch.hh"
+
+#include <cmath>
+
+// The vector variants of cos in glibc's libmvec, as <bits/math-vector.h> declares them under -ffast-math.
+// Declared here so the omp simd loops below use them while this file keeps IEEE semantics (CMakeLists.txt).
+#if defined(__GNUC__) && !defined(__clang__) && defined(__GLIBC__) && defined(__x86_64__) && !defined(__FAST_MATH__)
+extern "C" double cos(double) __attribute__((__simd__("notinbranch")));
+#endif
+
+
+PrimaryBatch::PrimaryBatch(const size_t capacity, const FluxDir dir, const G4ThreeVector &c, const G4double r,
+                           const G4ThreeVector &halfSize)
+    : direction(dir), center(c), radius(r), detectorHalfSize(halfSize) {
+    const size_t n = std::max<size_t>(capacity, 1);
+    rnd.resize(4 * n);
+    px.resize(n);
+    py.resize(n);
+    pz.resize(n);
+    dx.resize(n);
+    dy.resize(n);
+    dz.resize(n);
+    info.resize(n);
+    head = n;
+}
+
+
+void PrimaryBatch::Refill() {
+    G4Random::getTheEngine()->flatArray(static_cast<G4int>(rnd.size()), rnd.data());
+
+    switch (direction) {
+        case FluxDir::Vertical_up:
+            FillVertical(-radius, 1.0);
+            break;
+        case FluxDir::Vertical_down:
+            FillVertical(radius, -1.0);
+            break;
+        case FluxDir::Horizontal:
+            FillHorizontal();
+            break;
+        case FluxDir::Isotropic_up:
+            FillSphere(0.0, 1.0);   // cos(theta) ~ U[0,1]
+            break;
+        case FluxDir::Isotropic_down:
+            FillSphere(0.0, -1.0);  // cos(theta) ~ U[-1,0]
+            break;
+        case FluxDir::Isotropic:
+            FillSphere(-1.0, 2.0);  // cos(theta) ~ U[-1,1]
+            break;
+    }
+    head = 0;
+}
+
+
+void PrimaryBatch::Pop(G4ThreeVector &pos, G4ThreeVector &dir, ParticleInfo &particle) {
+    pos.set(px[head], py[head], pz[head]);
+    dir.set(dx[head], dy[head], dz[head]);
+    particle = info[head];
+    ++head;
+}
+
+
+// Same distribution as PrimaryGeneratorAction::GenerateOnSphere: a point on the sphere and a cosine-law
+// inward direction around its normal. The pole switch of the local frame is a select, not a branch.
+// Sines are written as shifted cosines: GCC fuses sin(x) and cos(x) into sincos, which has no vector
+// variant, while two cos calls both go to libmvec.
+void PrimaryBatch::FillSphere(const G4double cosA, const G4double cosB) {
+    const size_t n = Size();
+    const G4double *u = rnd.data();
+    const G4double *w = u + n;
+    const G4double *k = w + n;
+    const G4double *w2 = k + n;
+    const G4double cx = center.x(), cy = center.y(), cz = center.z();
+    const G4double R = radius;
+    G4double *X = px.data(), *Y = py.data(), *Z = pz.data();
+    G4double *DX = dx.data(), *DY = dy.data(), *DZ = dz.data();
+
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        const G4double rz = cosA + cosB * u[i];
+        const G4double l = std::sqrt(std::max(0.0, 1.0 - rz * rz));
+        const G4double phi = twopi * w[i];
+        const G4double rx = l * std::cos(phi);
+        const G4double ry = l * std::cos(phi - halfpi);
+
+        X[i] = cx + R * rx;
+        Y[i] = cy + R * ry;
+        Z[i] = cz + R * rz;
+
+        // x = normalised z × a, a = e_z away from the poles and e_x near them
+        const bool pole = std::abs(rz) >= 0.999;
+        G4double ex = pole ? 0.0 : ry;
+        G4double ey = pole ? rz : -rx;
+        G4double ez = pole ? -ry : 0.0;
+        const G4double invX = 1.0 / std::sqrt(ex * ex + ey * ey + ez * ez);
+        ex *= invX;
+        ey *= invX;
+        ez *= invX;
+
+        // y = z × x
+        const G4double fx = ry * ez - rz * ey;
+        const G4double fy = rz * ex - rx * ez;
+        const G4double fz = rx * ey - ry * ex;
+
+        const G4double sinTh = std::sqrt(k[i]);
+        const G4double cosTh = std::sqrt(1.0 - k[i]);
+        const G4double phi2 = twopi * w2[i];
+        const G4double a = sinTh * std::cos(phi2);
+        const G4double b = sinTh * std::cos(phi2 - halfpi);
+
+        const G4double vx = -(a * ex + b * fx + cosTh * rx);
+        const G4double vy = -(a * ey + b * fy + cosTh * ry);
+        const G4double vz = -(a * ez + b * fz + cosTh * rz);
+        const G4double invV = 1.0 / std::sqrt(vx * vx + vy * vy + vz * vz);
+        DX[i] = vx * invV;
+        DY[i] = vy * invV;
+        DZ[i] = vz * invV;
+    }
+}
+
+
+void PrimaryBatch::FillVertical(const G4double z, const G4double dirZ) {
+    const size_t n = Size();
+    const G4double *u = rnd.data();
+    const G4double *w = u + n;
+    const G4double R = detectorHalfSize.y();
+    G4double *X = px.data(), *Y = py.data(), *Z = pz.data();
+    G4double *DX = dx.data(), *DY = dy.data(), *DZ = dz.data();
+
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        const G4double r = std::sqrt(u[i]) * R;
+        const G4double phi = twopi * w[i];
+        X[i] = r * std::cos(phi);
+        Y[i] = r * std::cos(phi - halfpi);
+        Z[i] = z;
+        DX[i] = 0.0;
+        DY[i] = 0.0;
+        DZ[i] = dirZ;
+    }
+}
+
+
+void PrimaryBatch::FillHorizontal() {
+    const size_t n = Size();
+    const G4double *u = rnd.data();
+    const G4double *w = u + n;
+    const G4double halfY = detectorHalfSize.y();
+    const G4double H = detectorHalfSize.z();
+    const G4double R = radius;
+    G4double *X = px.data(), *Y = py.data(), *Z = pz.data();
+    G4double *DX = dx.data(), *DY = dy.data(), *DZ = dz.data();
+
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i) {
+        X[i] = R;
+        Y[i] = 2 * (u[i] - 0.5) * halfY;
+        Z[i] = (w[i] - 0.5) * H;
+        DX[i] = -1.0;
+        DY[i] = 0.0;
+        DZ[i] = 0.0;
+    }
+}
@@ -1,7 +1,8 @@
 #include "PrimaryGeneratorAction.hh"
 
 
-PrimaryGeneratorAction::PrimaryGeneratorAction(G4String fDir, const G4String& fluxType, const G4double cThreshold)
+PrimaryGeneratorAction::PrimaryGeneratorAction(G4String fDir, const G4String& fluxType, const G4double cThreshold,
+                                               const SharedSpectra &spectra)
     : particleGun(new G4ParticleGun(1)),
       center(G4ThreeVector(0, 0, -Sizes::modelHeight / 2.0)),
       detectorHalfSize(G4ThreeVector(0 * mm, Sizes::modelRadius, Sizes::modelHeight)),
@@ -12,51 +13,70 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(G4String fDir, const G4String& fl
                                                 detectorHalfSize.z());
     radius = sqrt(tempVec.y() * tempVec.y() + tempVec.z() * tempVec.z()) + 5 * mm;
 
-    std::vector<G4String> fluxDirList = {
-        "isotropic", "isotropic_up", "isotropic_down", "vertical_up", "vertical_down", "horizontal"
-    };
-    if (std::find(fluxDirList.begin(), fluxDirList.end(), fluxDirection) == fluxDirList.end()) {
+    // Envelope of all material, with a 1 mm margin: the tuna can down to the bottom cap, plus the plate slab
+    const G4double margin = 1 * mm;
+    envRadius = Sizes::modelRadius + margin;
+    envZMax = Sizes::modelHeight / 2 + margin;
+    envZMin = -Sizes::modelHeight / 2 - Sizes::plateThick - Sizes::plateCenterThick - Sizes::bottomCapHeight - margin;
+    plateHalfXY = Sizes::plateSize / 2 + Sizes::plateCornerSize + margin;
+    plateZMax = -Sizes::modelHeight / 2 + margin;
+    plateZMin = -Sizes::modelHeight / 2 - std::max(Sizes::plateThick, Sizes::plateCenterThick) - margin;
+
+    if (!fluxDirFromName(fluxDirection, direction)) {
         G4Exception("PrimaryGeneratorAction::GeneratePrimaries", "FluxDirection", FatalException,
                     ("Flux direction is not implemented: " + fluxDirection +
                         ".\nAvailable flux directions: isotropic, isotropic_up, isotropic_down, vertical_up," +
                         " vertical_down, horizontal").c_str());
     }
-    std::vector<G4String> fluxTypeList = {"Uniform", "PLAW", "COMP", "SEP", "Galactic", "Table"};
+    std::vector<G4String> fluxTypeList = {"Uniform", "PLAW", "COMP", "SEP", "Galactic", "Table", "Composite"};
     if (std::find(fluxTypeList.begin(), fluxTypeList.end(), fluxType) == fluxTypeList.end()) {
         G4Exception("PrimaryGeneratorAction::GeneratePrimaries", "FluxType", FatalException,
-                    ("Flux type not found: " + fluxType + ".\nAvailable flux types: Uniform, PLAW, SEP, Galactic")
+                    ("Flux type not found: " + fluxType + ".\nAvailable flux types: Uniform, PLAW, COMP, SEP, Galactic, Table, Composite")
                     .
                     c_str());
     }
 
-    if (fluxType == "Uniform") {
-        flux = new UniformFlux(eCrystalThreshold);
-    } else if (fluxType == "PLAW") {
-        flux = new PLAWFlux(eCrystalThreshold);
-    } else if (fluxType == "COMP") {
-        flux = new COMPFlux(eCrystalThreshold);
-    } else if (fluxType == "SEP") {
-        flux = new SEPFlux(eCrystalThreshold);
-    } else if (fluxType == "Galactic") {
-        flux = new GalacticFlux(eCrystalThreshold);
-    } else if (fluxType == "Table") {
-        flux = new TableFlux(eCrystalThreshold);
+    std::vector<G4String> energyBiasList = {"none", "logflat", "stratified"};
+    if (std::find(energyBiasList.begin(), energyBiasList.end(), Configuration::energyBias) == energyBiasList.end()) {
+        G4Exception("PrimaryGeneratorAction::PrimaryGeneratorAction", "EnergyBias", FatalException,
+                    ("Energy bias is not implemented: " + Configuration::energyBias +
+                        ".\nAvailable energy biases: none, logflat, stratified").c_str());
+    }
+
+    if (Configuration::pileupRate > 0 && Configuration::energyBias != "none") {
+        G4Exception("PrimaryGeneratorAction::PrimaryGeneratorAction", "PileUp", FatalException,
+                    "Pile-up background must follow the source spectrum: use --pileup-rate with --energy-bias none");
+    }
+
+    if (Configuration::energyBias == "logflat") bias = EnergyBias::LogFlat;
+    else if (Configuration::energyBias == "stratified") bias = EnergyBias::Stratified;
+    culling = Configuration::rayCulling && isIsotropic(direction);
+
+    flux = Flux::Create(fluxType, eCrystalThreshold, spectra);
+    flux->SetEnergyBias(Configuration::energyBias);
+
+    if (Configuration::primaryBatch > 0) {
+        batch = new PrimaryBatch(Configuration::primaryBatch, direction, center, radius, detectorHalfSize);
     }
 }
 
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction() {
     delete particleGun;
+    delete flux;
+    delete stratified;
+    delete batch;
+    delete calibration;
 }
 
 
 void PrimaryGeneratorAction::GenerateOnSphere(G4ThreeVector& pos, G4ThreeVector& dir) const {
     G4double u = 0;
-    if (fluxDirection == "isotropic") {
+    if (direction == FluxDir::Isotropic) {
         u = 2.0 * G4UniformRand() - 1.0; // cos(theta) ~ U[-1,1]
-    } else if (fluxDirection == "isotropic_up") {
+    } else if (direction == FluxDir::Isotropic_up) {
         u = G4UniformRand(); // cos(theta) ~ U[0,1]
-    } else if (fluxDirection == "isotropic_down") {
+    } else if (direction == FluxDir::Isotropic_down) {
         u = -G4UniformRand(); // cos(theta) ~ U[-1,0]
     }
     const G4double phi = 2.0 * M_PI * G4UniformRand();
@@ -82,9 +102,76 @@ void PrimaryGeneratorAction::GenerateOnSphere(G4ThreeVector& pos, G4ThreeVector&
 }
 
 
-void PrimaryGeneratorAction::GeneratePrimaries(G4Event* evt) {
-    G4ThreeVector x, v;
-    if (fluxDirection == "vertical_up") {
+// Parametric range [tMin, tMax] of the ray inside the slab lo <= p + t d <= hi along one axis
+static bool ClipSlab(const G4double p, const G4double d, const G4double lo, const G4double hi,
+                     G4double& tMin, G4double& tMax) {
+    if (std::abs(d) < 1e-12) return p >= lo && p <= hi;
+    G4double t1 = (lo - p) / d;
+    G4double t2 = (hi - p) / d;
+    if (t1 > t2) std::swap(t1, t2);
+    tMin = std::max(tMin, t1);
+    tMax = std::min(tMax, t2);
+    return tMin <= tMax;
+}
+
+
+G4bool PrimaryGeneratorAction::HitsEnvelope(const G4ThreeVector& pos, const G4ThreeVector& dir) const {
+    // Plate: axis-aligned box
+    {
+        G4double tMin = 0, tMax = DBL_MAX;
+        if (ClipSlab(pos.x(), dir.x(), -plateHalfXY, plateHalfXY, tMin, tMax) &&
+            ClipSlab(pos.y(), dir.y(), -plateHalfXY, plateHalfXY, tMin, tMax) &&
+            ClipSlab(pos.z(), dir.z(), plateZMin, plateZMax, tMin, tMax)) {
+            return true;
+        }
+    }
+
+    // Tuna can: finite cylinder along z
+    G4double tMin = 0, tMax = DBL_MAX;
+    if (!ClipSlab(pos.z(), dir.z(), envZMin, envZMax, tMin, tMax)) return false;
+
+    const G4double a = dir.x() * dir.x() + dir.y() * dir.y();
+    const G4double b = pos.x() * dir.x() + pos.y() * dir.y();
+    const G4double c = pos.x() * pos.x() + pos.y() * pos.y() - envRadius * envRadius;
+    if (a < 1e-12) return c <= 0;
+
+    const G4double disc = b * b - a * c;
+    if (disc < 0) return false;
+    const G4double sq = std::sqrt(disc);
+    tMin = std::max(tMin, (-b - sq) / a);
+    tMax = std::min(tMax, (-b + sq) / a);
+    return tMin <= tMax;
+}
+
+
+void PrimaryGeneratorAction::SampleParticle(ParticleInfo& info) {
+    if (bias != EnergyBias::Stratified) {
+        info = flux->GenerateParticle();
+        return;
+    }
+    // Only the species comes from the flux. The effective area is a per-bin trig/gen ratio that does not
+    // depend on how energies are spread over the bins, so stratified primaries are unweighted.
+    if (!stratified) stratified = new StratifiedSampler(run);
+    info = flux->GenerateSpecies();
+    info.energy = stratified->SampleEnergy() * MeV;
+    info.weight = 1.0;
+}
+
+
+void PrimaryGeneratorAction::RefillBatch() {
+    batch->Refill();
+    for (auto& info : batch->Info()) SampleParticle(info);
+}
+
+
+void PrimaryGeneratorAction::DrawPrimary(G4ThreeVector& x, G4ThreeVector& v, ParticleInfo& info) {
+    if (batch) {
+        if (batch->Empty()) RefillBatch();
+        batch->Pop(x, v, info);
+        return;
+    }
+
+    if (direction == FluxDir::Vertical_up) {
         v = G4ThreeVector(0., 0., 1.);
         const G4double r = std::sqrt(G4UniformRand()) * detectorHalfSize.y(); // 1 * mm;
         const G4double phi = G4UniformRand() * 2 * pi;
@@ -92,7 +179,7 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* evt) {
         const G4double y_ = r * std::sin(phi);
         const G4double z_ = -radius;
         x = G4ThreeVector(x_, y_, z_);
-    } else if (fluxDirection == "vertical_down") {
+    } else if (direction == FluxDir::Vertical_down) {
         v = G4ThreeVector(0., 0., -1.);
         const G4double r = std::sqrt(G4UniformRand()) * detectorHalfSize.y(); // 1 * mm;
         const G4double phi = G4UniformRand() * 2 * pi;
@@ -100,7 +187,7 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* evt) {
         const G4double y_ = r * std::sin(phi);
         const G4double z_ = radius;
         x = G4ThreeVector(x_, y_, z_);
-    } else if (fluxDirection == "horizontal") {
+    } else if (direction == FluxDir::Horizontal) {
         v = G4ThreeVector(-1., 0., 0.);
         const G4double x_ = radius;
         const G4double y_ = 2 * (G4UniformRand() - 0.5) * detectorHalfSize.y(); // 1 * mm;
@@ -109,24 +196,66 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* evt) {
     } else {
         GenerateOnSphere(x, v);
     }
-    ParticleInfo info = flux->GenerateParticle();
+    SampleParticle(info);
+}
 
+
+void PrimaryGeneratorAction::ShootPrimary(G4Event* evt, const G4ThreeVector& x, const G4ThreeVector& v,
+                                          const ParticleInfo& info, const G4double t0) {
     particleGun->SetParticleDefinition(info.def);
     particleGun->SetParticleEnergy(info.energy);
     particleGun->SetParticlePosition(x);
     particleGun->SetParticleMomentumDirection(v);
-    particleGun->SetParticleTime(0.0 * ns);
+    particleGun->SetParticleTime(t0);
     particleGun->GeneratePrimaryVertex(evt);
 
-    if (auto* ea = dynamic_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction())) {
+    if (events) {
         PrimaryRec rec;
-        rec.index = static_cast<int>(ea->primBuf.size());
+        rec.index = static_cast<int>(events->primBuf.size());
         rec.pdg = info.pdg;
-        rec.name = info.name;
+        rec.def = info.def;
         rec.E_MeV = info.energy / MeV;
         rec.dir = v;
         rec.pos_mm = x / mm;
-        rec.t0_ns = 0.0;
-        ea->primBuf.emplace_back(std::move(rec));
+        rec.t0_ns = t0 / ns;
+        rec.weight = info.weight;
+        rec.species = info.species;
+        events->primBuf.push_back(rec);
+    }
+}
+
+
+void PrimaryGeneratorAction::GeneratePrimaries(G4Event* evt) {
+    if (!run) run = dynamic_cast<RunAction*>(G4RunManager::GetRunManager()->GetUserRunAction());
+    if (!events) events = dynamic_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+
+    if (Configuration::lutCalibrate) {
+        if (!calibration) calibration = new LightCalibration();
+        const LUTEmission emission = calibration->Generate(evt);
+        if (events) events->lutEmission = emission;
+        return;
+    }
+
+    // Rays missing every volume only cross vacuum: count them as generated and draw again
+    G4ThreeVector x, v;
+    ParticleInfo info;
+    DrawPrimary(x, v, info);
+    while (culling && run && !HitsEnvelope(x, v)) {
+        run->AddCulled(info.energy / MeV, info.weight, info.species);
+        DrawPrimary(x, v, info);
+    }
+    ShootPrimary(evt, x, v, info, 0.0 * ns);
+
+    // Pile-up: background primaries arrive as a Poisson process over the window after the leading one.
+    // They are not histories of their own, so culled ones are simply dropped (thinning keeps it Poisson).
+    if (Configuration::pileupRate > 0 && Configuration::pileupWindow > 0) {
+        G4double t = 0.0;
+        for (;;) {
+            t -= std::log(1.0 - G4UniformRand()) / Configuration::pileupRate;
+            if (t >= Configuration::pileupWindow) break;
+            DrawPrimary(x, v, info);
+            if (culling && !HitsEnvelope(x, v)) continue;
+            ShootPrimary(evt, x, v, info, t);
+        }
     }
 }
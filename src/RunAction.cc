@@ -41,6 +41,8 @@ void RunAction::BookAccumulables() {
 
     mgr->Register(crystalOnlyOpt);
     mgr->Register(crystalAndVetoOpt);
+    mgr->Register(culled);
+    mgr->Register(aborted);
 
     genCounts.clear();
     trigCounts.clear();
@@ -59,6 +61,38 @@ void RunAction::BookAccumulables() {
         genCounts.emplace_back(0.0);
         mgr->Register(genCounts.back());
     }
+
+    const size_t nSpecies = fluxComponents.size();
+    speciesGen.clear();
+    speciesTrig.clear();
+    speciesTrigOpt.clear();
+    speciesGen.reserve(nSpecies);
+    speciesTrig.reserve(nSpecies);
+    speciesTrigOpt.reserve(nSpecies);
+    for (size_t i = 0; i < nSpecies; ++i) {
+        speciesGen.emplace_back(0.0);
+        mgr->Register(speciesGen.back());
+        speciesTrig.emplace_back(0.0);
+        mgr->Register(speciesTrig.back());
+        speciesTrigOpt.emplace_back(0.0);
+        mgr->Register(speciesTrigOpt.back());
+    }
+
+    const size_t nSpeciesBins = EminMeV < EmaxMeV ? nSpecies * nBins : 0;
+    speciesGenCounts.clear();
+    speciesTrigCounts.clear();
+    speciesTrigOptCounts.clear();
+    speciesGenCounts.reserve(nSpeciesBins);
+    speciesTrigCounts.reserve(nSpeciesBins);
+    speciesTrigOptCounts.reserve(nSpeciesBins);
+    for (size_t i = 0; i < nSpeciesBins; ++i) {
+        speciesGenCounts.emplace_back(0.0);
+        mgr->Register(speciesGenCounts.back());
+        speciesTrigCounts.emplace_back(0.0);
+        mgr->Register(speciesTrigCounts.back());
+        speciesTrigOptCounts.emplace_back(0.0);
+        mgr->Register(speciesTrigOptCounts.back());
+    }
 }
 
 RunAction::~RunAction() {
@@ -72,6 +106,9 @@ void RunAction::BeginOfRunAction(const G4Run*) {
 
     totals = {};
     totalsOpt = {};
+    totalCulled = 0.0;
+    totalAborted = 0.0;
+    speciesTotals.clear();
     std::fill(effArea.begin(), effArea.end(), 0.0);
     std::fill(effAreaOpt.begin(), effAreaOpt.end(), 0.0);
 }
@@ -84,9 +121,27 @@ void RunAction::EndOfRunAction(const G4Run*) {
         totals.crystalOnly = crystalOnly.GetValue();
         totalsOpt.crystalAndVeto = crystalAndVetoOpt.GetValue();
         totalsOpt.crystalOnly = crystalOnlyOpt.GetValue();
+        totalCulled = culled.GetValue();
+        totalAborted = aborted.GetValue();
+        speciesTotals.resize(speciesGen.size());
+        for (size_t i = 0; i < speciesGen.size(); ++i) {
+            speciesTotals[i] = {speciesGen[i].GetValue(), speciesTrig[i].GetValue(), speciesTrigOpt[i].GetValue()};
+        }
         if (EminMeV < EmaxMeV) {
             FillDerivedHists();
         }
+        if (lutCalibrate) {
+            LightLUT::WriteCalibration(lutFile);
+        }
+        if (saveSecondaries) {
+            for (const CodeKind kind: {CodeKind::Process, CodeKind::Volume, CodeKind::Particle}) {
+                const auto names = InteractionCodes::Names(kind);
+                for (size_t i = 0; i < names.size(); ++i) {
+                    analysisManager->FillDictionaryRow(InteractionCodes::KindName(kind), static_cast<G4int>(i),
+                                                       names[i]);
+                }
+            }
+        }
     }
 
     analysisManager->Close();
@@ -127,40 +182,63 @@ double RunAction::BinWidthMeV(int i) const {
     return e2 - e1;
 }
 
-void RunAction::AddGenerated(double E_MeV) {
+void RunAction::AddGenerated(double E_MeV, double weight, int species) {
+    if (species >= 0 && species < static_cast<int>(speciesGen.size())) speciesGen[species] += weight;
+
     const int i = EminMeV < EmaxMeV ? FindBinLog(E_MeV) : 0;
     if (i < 0) return;
 
-    genCounts[i] += 1.0;
+    genCounts[i] += weight;
+    if (species >= 0 && species < static_cast<int>(speciesGen.size()) && !speciesGenCounts.empty()) {
+        speciesGenCounts[species * nBins + i] += weight;
+    }
 
     if (analysisManager and EminMeV < EmaxMeV) {
-        analysisManager->FillGenEnergyHist(E_MeV, 1.0);
+        analysisManager->FillGenEnergyHist(E_MeV, weight);
     }
 }
 
-void RunAction::AddTriggeredCrystalOnly(double E_MeV) {
+void RunAction::AddCulled(double E_MeV, double weight, int species) {
+    culled += 1.0;
+    AddGenerated(E_MeV, weight, species);
+}
+
+void RunAction::AddTriggeredCrystalOnly(double E_MeV, double weight, int species) {
+    if (species >= 0 && species < static_cast<int>(speciesTrig.size())) speciesTrig[species] += weight;
+
     const int i = FindBinLog(E_MeV);
     if (i < 0) return;
 
-    trigCounts[i] += 1.0;
+    trigCounts[i] += weight;
+    if (species >= 0 && species < static_cast<int>(speciesTrig.size()) && !speciesTrigCounts.empty()) {
+        speciesTrigCounts[species * nBins + i] += weight;
+    }
 
     if (analysisManager and EminMeV < EmaxMeV) {
-        analysisManager->FillTrigEnergyHist(E_MeV, 1.0);
+        analysisManager->FillTrigEnergyHist(E_MeV, weight);
     }
 }
 
-void RunAction::AddTriggeredCrystalOnlyOpt(double E_MeV) {
+void RunAction::AddTriggeredCrystalOnlyOpt(double E_MeV, double weight, int species) {
+    if (species >= 0 && species < static_cast<int>(speciesTrigOpt.size())) speciesTrigOpt[species] += weight;
+
     const int i = FindBinLog(E_MeV);
     if (i < 0) return;
 
-    trigOptCounts[i] += 1.0;
+    trigOptCounts[i] += weight;
+    if (species >= 0 && species < static_cast<int>(speciesTrigOpt.size()) && !speciesTrigOptCounts.empty()) {
+        speciesTrigOptCounts[species * nBins + i] += weight;
+    }
 
     if (analysisManager and EminMeV < EmaxMeV) {
-        analysisManager->FillTrigOptEnergyHist(E_MeV, 1.0);
+        analysisManager->FillTrigOptEnergyHist(E_MeV, weight);
     }
 }
 
 void RunAction::FillDerivedHists() {
+    FluxDir dir = FluxDir::Isotropic;
+    fluxDirFromName(fluxDirection, dir);
+    const bool isotropic = isIsotropic(dir);
     for (int i = 0; i < nBins; ++i) {
         const double nGen = genCounts[i].GetValue();
         const double nTrig = trigCounts[i].GetValue();
@@ -179,11 +257,25 @@ void RunAction::FillDerivedHists() {
         }
         effArea[i] = aEff;
         effAreaOpt[i] = aEffOpt;
-        if (fluxDirection.find("isotropic") != std::string::npos) {
+        if (isotropic) {
             analysisManager->FillSensitivityHist(centerE, sens);
             analysisManager->FillSensitivityOptHist(centerE, sensOpt);
         }
         analysisManager->FillEffAreaHist(centerE, aEff);
         analysisManager->FillEffAreaOptHist(centerE, aEffOpt);
     }
+
+    if (speciesGenCounts.empty()) return;
+    for (size_t s = 0; s < speciesTotals.size(); ++s) {
+        SpeciesCounts& sc = speciesTotals[s];
+        sc.effArea.assign(nBins, 0.0);
+        sc.effAreaOpt.assign(nBins, 0.0);
+        for (int i = 0; i < nBins; ++i) {
+            const size_t k = s * nBins + i;
+            const double nGen = speciesGenCounts[k].GetValue();
+            if (nGen <= 0.0) continue;
+            sc.effArea[i] = area * (speciesTrigCounts[k].GetValue() / nGen);
+            sc.effAreaOpt[i] = area * (speciesTrigOptCounts[k].GetValue() / nGen);
+        }
+    }
 }
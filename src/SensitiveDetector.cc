@@ -6,13 +6,27 @@ SensitiveDetector::SensitiveDetector(const G4String &sdName, G4int detID, G4Stri
     collectionName.insert("EdepHits");
 }
 
-void SensitiveDetector::Initialize(G4HCofThisEvent *hce) {
-    hits = new SDHitCollection(SensitiveDetectorName, collectionName[0]);
-    indexByVol.clear();
+void SensitiveDetector::Initialize(G4HCofThisEvent *) {
+    ++generation;
+    hits = nullptr;
+    touched.clear();
+}
+
+void SensitiveDetector::EndOfEvent(G4HCofThisEvent *hce) {
+    // Left out of the event entirely when nothing was deposited; EventAction skips a missing collection
+    if (touched.empty()) return;
 
+    hits = new SDHitCollection(SensitiveDetectorName, collectionName[0]);
     if (HCID < 0) {
         HCID = G4SDManager::GetSDMpointer()->GetCollectionID(hits);
     }
+    for (const G4int volumeID : touched) {
+        const Slot &slot = slots[volumeID];
+        auto *h = new SDHit(volumeID);
+        h->AddEdep(slot.edep);
+        h->UpdateTmin(slot.tmin);
+        hits->insert(h);
+    }
     hce->AddHitsCollection(HCID, hits);
 }
 
@@ -30,21 +44,35 @@ G4bool SensitiveDetector::ProcessHits(G4Step *step, G4TouchableHistory *) {
 
     const G4double t = step->GetPreStepPoint()->GetGlobalTime();
 
-    SDHit *hit = FindOrCreateHit(volumeID);
-    hit->AddEdep(edep);
-    hit->UpdateTmin(t);
+    Slot &slot = Touch(volumeID);
+    slot.edep += edep;
+    if (t < slot.tmin) slot.tmin = t;
+
+    // Same per-hit threshold as EventAction::WriteEdepFromSD_
+    if (Configuration::earlyAbort && detID != 0 && slot.edep > Configuration::eVetoThreshold) {
+        if (!events) events = dynamic_cast<EventAction *>(G4EventManager::GetEventManager()->GetUserEventAction());
+        if (events) events->VetoFired(false);
+    }
+
+    if (Configuration::lightLUT) {
+        if (!light) light = std::make_unique<LightLUTSampler>(detID);
+        light->Deposit(step);
+    }
 
     return true;
 }
 
-SDHit *SensitiveDetector::FindOrCreateHit(G4int volumeID) {
-    auto it = indexByVol.find(volumeID);
-    if (it != indexByVol.end()) {
-        return (*hits)[it->second];
+SensitiveDetector::Slot &SensitiveDetector::Touch(const G4int volumeID) {
+    if (volumeID < 0) {
+        G4Exception("SensitiveDetector::Touch", "NegativeCopyNo", FatalException,
+                    ("negative copy number in " + detName).c_str());
     }
+    if (volumeID >= static_cast<G4int>(slots.size())) slots.resize(volumeID + 1);
 
-    auto *h = new SDHit(volumeID);
-    int idx = hits->insert(h) - 1;
-    indexByVol.emplace(volumeID, idx);
-    return h;
-}
\ No newline at end of file
+    Slot &slot = slots[volumeID];
+    if (slot.generation != generation) {
+        slot = Slot{0.0, DBL_MAX, generation};
+        touched.push_back(volumeID);
+    }
+    return slot;
+}
@@ -1,13 +1,55 @@
 #include "SiPMOpticalSD.hh"
 
+#include "Sizes.hh"
+
 SiPMOpticalSD::SiPMOpticalSD(const G4String& name)
     : G4VSensitiveDetector(name) {}
 
 void SiPMOpticalSD::Initialize(G4HCofThisEvent*) {
-    npeCrystal = npeVeto = npeBottom = 0;
-    perChCrystal.clear();
-    perChVeto.clear();
-    perChBottom.clear();
+    crystal = veto = bottom = SiPMChannel{};
+    perChCrystal.assign(Sizes::crystalSiPMCount, SiPMChannel{});
+    perChVeto.assign(Sizes::vetoSiPMCount, SiPMChannel{});
+    perChBottom.assign(Sizes::bottomVetoSiPMCount, SiPMChannel{});
+}
+
+void SiPMOpticalSD::Count(SiPMChannel& c, const double npe, const double var, const double t) {
+    c.npe += npe;
+    c.var += var;
+    if (t < c.tFirst) c.tFirst = t;
+}
+
+void SiPMOpticalSD::Count(SiPMChannel& total, std::vector<SiPMChannel>& perCh,
+                          const int ch, const double npe, const double var, const double t) {
+    Count(total, npe, var, t);
+    if (ch >= 0 && ch < static_cast<int>(perCh.size())) Count(perCh[ch], npe, var, t);
+}
+
+void SiPMOpticalSD::AddDetected(const SiPMGroup grp, const int ch, const double npe, const double t) {
+    if (grp == SiPMGroup::Crystal) Count(crystal, perChCrystal, ch, npe, npe, t);
+    else if (grp == SiPMGroup::Veto) Count(veto, perChVeto, ch, npe, npe, t);
+    else if (grp == SiPMGroup::Bottom) Count(bottom, perChBottom, ch, npe, npe, t);
+    if (grp != SiPMGroup::Crystal) CheckVeto();
+}
+
+// Same thresholds as EventAction::WriteSiPMFromSD_
+void SiPMOpticalSD::CheckVeto() {
+    if (!Configuration::earlyAbort) return;
+    if (veto.npe <= Configuration::oVetoThreshold && bottom.npe <= Configuration::oBottomVetoThreshold) return;
+    if (!events) events = dynamic_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+    if (events) events->VetoFired(true);
+}
+
+G4bool SiPMOpticalSD::Saturated(const SiPMGroup grp) const {
+    using namespace Configuration;
+    if (grp == SiPMGroup::Crystal) return npeCapCrystal > 0 && crystal.npe >= npeCapCrystal;
+    if (grp == SiPMGroup::Veto) return npeCapVeto > 0 && veto.npe >= npeCapVeto;
+    if (grp == SiPMGroup::Bottom) return npeCapBottomVeto > 0 && bottom.npe >= npeCapBottomVeto;
+    return false;
+}
+
+G4int SiPMOpticalSD::SaturationBits() const {
+    return (Saturated(SiPMGroup::Crystal) ? 1 : 0) | (Saturated(SiPMGroup::Veto) ? 2 : 0)
+           | (Saturated(SiPMGroup::Bottom) ? 4 : 0);
 }
 
 G4OpBoundaryProcess* SiPMOpticalSD::GetBoundaryProcess() {
@@ -29,15 +71,13 @@ G4OpBoundaryProcess* SiPMOpticalSD::GetBoundaryProcess() {
 }
 
 
-SiPMGroup SiPMOpticalSD::ClassifyByPVName(const G4VPhysicalVolume* pv) {
-    if (!pv) return SiPMGroup::Unknown;
-    const std::string name = pv->GetName();
-
-    if (name.find("CrystalSiPM") != std::string::npos) return SiPMGroup::Crystal;
-    if (name.find("BottomVetoSiPM") != std::string::npos) return SiPMGroup::Bottom;
-    if (name.find("VetoSiPM") != std::string::npos) return SiPMGroup::Veto;
-
-    return SiPMGroup::Unknown;
+SiPMSlot SiPMOpticalSD::Lookup(const G4VPhysicalVolume* prePV, const G4VPhysicalVolume* postPV) const {
+    if (!registry) return {};
+    auto it = registry->find(prePV);
+    if (it != registry->end()) return it->second;
+    it = registry->find(postPV);
+    if (it != registry->end()) return it->second;
+    return {};
 }
 
 G4bool SiPMOpticalSD::ProcessHits(G4Step* step, G4TouchableHistory*) {
@@ -60,67 +100,40 @@ G4bool SiPMOpticalSD::ProcessHits(G4Step* step, G4TouchableHistory*) {
 
     if (b->GetStatus() != Detection) return false;
 
-    // Determine on which PV we are (prefer PRE, but keep fallback)
-    auto* prePV = pre->GetPhysicalVolume();
-    auto* postPV = post->GetPhysicalVolume();
-
-    // Prefer pre-step touchable for copy number (normally it's the "window" volume)
-    int ch = -1;
-    {
-        const auto& t = pre->GetTouchableHandle();
-        if (t) ch = t->GetCopyNumber(0);
-    }
-    if (ch < 0) {
-        const auto& t = post->GetTouchableHandle();
-        if (t) ch = t->GetCopyNumber(0);
-    }
+    // Window and body placements are registered by Detector; prefer the pre-step one (normally the window)
+    const SiPMSlot slot = Lookup(pre->GetPhysicalVolume(), post->GetPhysicalVolume());
+    const SiPMGroup grp = slot.group;
+    const int ch = slot.ch;
 
-    SiPMGroup grp = SiPMGroup::Unknown;
-
-    if (SiPMWindowLV) {
-        auto* preLV = prePV ? prePV->GetLogicalVolume() : nullptr;
-        auto* postLV = postPV ? postPV->GetLogicalVolume() : nullptr;
-
-        if (preLV == SiPMWindowLV) {
-            grp = ClassifyByPVName(prePV);
-        } else if (postLV == SiPMWindowLV) {
-            grp = ClassifyByPVName(postPV);
-        } else {
-            // Not on a SiPM window at all (or LV pointers differ); fall back to name check
-            grp = ClassifyByPVName(prePV);
-            if (grp == SiPMGroup::Unknown) grp = ClassifyByPVName(postPV);
-        }
-    } else {
-        grp = ClassifyByPVName(prePV);
-        if (grp == SiPMGroup::Unknown) grp = ClassifyByPVName(postPV);
-    }
-    G4String detName = "";
+    const char* detName = "";
+    const double w = track->GetWeight();
+    const double t = post->GetGlobalTime();
     if (grp == SiPMGroup::Crystal) {
         detName = "Crystal";
-        ++npeCrystal;
-        if (ch >= 0) ++perChCrystal[ch];
+        Count(crystal, perChCrystal, ch, w, w * w, t);
     } else if (grp == SiPMGroup::Veto) {
         detName = "Veto";
-        ++npeVeto;
-        if (ch >= 0) ++perChVeto[ch];
+        Count(veto, perChVeto, ch, w, w * w, t);
+        CheckVeto();
     } else if (grp == SiPMGroup::Bottom) {
         detName = "BottomVeto";
-        ++npeBottom;
-        if (ch >= 0) ++perChBottom[ch];
+        Count(bottom, perChBottom, ch, w, w * w, t);
+        CheckVeto();
     } else {
         // Unknown classification: still kill photon to avoid infinite bouncing after "Detection"
         // but do not count it.
     }
 
     if (Configuration::savePhotons) {
-        if (auto* ea = dynamic_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction())) {
+        if (!events) events = dynamic_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+        if (events) {
             PhotonRec rec;
             rec.photonID = track->GetTrackID();
             rec.detName = detName;
             rec.detCh = ch;
             rec.energy = track->GetTotalEnergy() / eV;
             rec.pos_mm = post->GetPosition();
-            ea->photonBuf.emplace_back(std::move(rec));
+            events->photonBuf.emplace_back(std::move(rec));
         }
     }
     track->SetTrackStatus(fStopAndKill);
@@ -0,0 +1,55 @@
+#include "StackingAction.hh"
+
+
+void StackingAction::Resolve() {
+    auto *store = G4PhysicalVolumeStore::GetInstance();
+    crystalPV = store->GetVolume("CrystalPVP", false);
+    vetoPV = store->GetVolume("VetoPVP", false);
+    bottomVetoPV = store->GetVolume("BottomVetoPVP", false);
+    events = dynamic_cast<EventAction *>(G4EventManager::GetEventManager()->GetUserEventAction());
+    sipmSD = dynamic_cast<SiPMOpticalSD *>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("SiPMOpticalSD", false));
+    resolved = true;
+}
+
+
+PhotonOrigin StackingAction::Origin(const G4Track *track) const {
+    // New secondaries carry the touchable of the step that created them
+    const G4VPhysicalVolume *pv = track->GetTouchableHandle() ? track->GetTouchableHandle()->GetVolume() : nullptr;
+    if (!pv) return PhotonOrigin::Other;
+    if (pv == crystalPV) return PhotonOrigin::Crystal;
+    if (pv == vetoPV) return PhotonOrigin::Veto;
+    if (pv == bottomVetoPV) return PhotonOrigin::BottomVeto;
+    return PhotonOrigin::Other;
+}
+
+
+SiPMGroup StackingAction::Group(const PhotonOrigin origin) {
+    switch (origin) {
+        case PhotonOrigin::Crystal: return SiPMGroup::Crystal;
+        case PhotonOrigin::Veto: return SiPMGroup::Veto;
+        case PhotonOrigin::BottomVeto: return SiPMGroup::Bottom;
+        default: return SiPMGroup::Unknown;
+    }
+}
+
+
+G4ClassificationOfNewTrack StackingAction::ClassifyNewTrack(const G4Track *track) {
+    if (track->GetDefinition() != G4OpticalPhoton::Definition()) return fUrgent;
+    if (!resolved) Resolve();
+
+    if (thinning > 1) {
+        const auto *creator = track->GetCreatorProcess();
+        if (!(creator && creator->GetProcessSubType() == fScintillation) && G4UniformRand() * thinning >= 1) {
+            return fKill;
+        }
+        // The kernel does not let the stacking action modify tracks, but the weight is ours to set
+        const_cast<G4Track *>(track)->SetWeight(track->GetWeight() * thinning);
+    }
+
+    const PhotonOrigin origin = Origin(track);
+    if (events && Configuration::savePhotons && origin != PhotonOrigin::Other) {
+        events->photonCountBuf[static_cast<size_t>(origin)] += track->GetWeight();
+    }
+    if (capped && sipmSD && sipmSD->Saturated(Group(origin))) return fKill;
+    return policy ? policy(track, origin) : fUrgent;
+}
@@ -1,77 +1,91 @@
 #include "SteppingAction.hh"
 
 
+SteppingAction::SteppingAction() : filter(Configuration::secondariesFilter), policy(Configuration::photonPolicy) {}
+
+
+void SteppingAction::ResolveCap() {
+    auto *store = G4PhysicalVolumeStore::GetInstance();
+    for (G4int s = 0; s < LightLUT::nSources; ++s) scintPV[s] = store->GetVolume(LightLUT::SourcePV[s], false);
+    sipmSD = dynamic_cast<SiPMOpticalSD *>(G4SDManager::GetSDMpointer()->FindSensitiveDetector("SiPMOpticalSD", false));
+    capResolved = true;
+}
+
+
+G4bool SteppingAction::Saturated(const G4VPhysicalVolume *pv) const {
+    static constexpr SiPMGroup group[LightLUT::nSources] = {SiPMGroup::Crystal, SiPMGroup::Veto, SiPMGroup::Bottom};
+    if (!sipmSD || !pv) return false;
+    for (G4int s = 0; s < LightLUT::nSources; ++s) {
+        if (pv == scintPV[s]) return sipmSD->Saturated(group[s]);
+    }
+    return false;
+}
+
+
 void SteppingAction::UserSteppingAction(const G4Step* step) {
-    const auto* post = step->GetPostStepPoint();
-    const auto* postProc = post->GetProcessDefinedStep();
+    if (!events) events = static_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
+    if (!events) return;
 
-    const G4ThreeVector x = post->GetPosition() / mm;
-    const G4double t = post->GetGlobalTime() / ns;
+    if (step->GetTrack()->GetDefinition() == G4OpticalPhoton::Definition()) {
+        if (capped && step->GetTrack()->GetCurrentStepNumber() == 1) {
+            if (!capResolved) ResolveCap();
+            if (Saturated(step->GetPreStepPoint()->GetPhysicalVolume())) {
+                step->GetTrack()->SetTrackStatus(fStopAndKill);
+                return;
+            }
+        }
+        if (policy.Active()) policy.Apply(step, events->photonLoss);
+    }
+    if (!Configuration::saveSecondaries) return;
 
+    const auto* post = step->GetPostStepPoint();
     const auto* touch = post->GetTouchable();
-    G4String volName = "World";
-    int copyNo = -1;
-    if (touch && touch->GetVolume()) {
-        volName = touch->GetVolume()->GetName();
-        copyNo = touch->GetVolume()->GetCopyNo();
-    }
+    const G4VPhysicalVolume* pv = touch ? touch->GetVolume() : nullptr;
+    const G4int volume = codes.Volume(pv);
+
+    const auto* secs = step->GetSecondaryInCurrentStep();
+    const bool hasSecs = secs && !secs->empty();
 
     const auto* track = step->GetTrack();
     const G4int trackID = track->GetTrackID();
     const G4int parentID = track->GetParentID();
 
-    auto secs = step->GetSecondaryInCurrentStep();
-    auto* ea = static_cast<EventAction*>(G4EventManager::GetEventManager()->GetUserEventAction());
-    if (ea) {
-        if (secs && !secs->empty()) {
-            for (size_t i = 0; i < secs->size(); ++i) {
-                const auto* sc = (*secs)[i];
-                const auto* cp = sc->GetCreatorProcess();
-
-                if (sc->GetDefinition()->GetParticleName() == "opticalphoton" and Configuration::savePhotons) {
-                    if (volName == "CrystalPVP")
-                        ea->photonCountBuf[0] += 1;
-                    if (volName == "VetoPVP")
-                        ea->photonCountBuf[1] += 1;
-                    if (volName == "BottomVetoPVP")
-                        ea->photonCountBuf[2] += 1;
-                }
-                InteractionRec rec;
-                rec.trackID = trackID;
-                rec.parentID = parentID;
-                rec.process = cp ? cp->GetProcessName() : "unknown";
-                rec.volumeName = volName;
-                rec.volumeID = copyNo;
-                rec.pos_mm = x;
-                rec.t_ns = t;
-                rec.secIndex = static_cast<G4int>(i);
-                rec.secPDG = sc->GetDefinition()->GetPDGEncoding();
-                rec.secName = sc->GetDefinition()->GetParticleName();
-                rec.secE_MeV = sc->GetKineticEnergy() / MeV;
-                rec.secDir = sc->GetMomentumDirection();
-                ea->interBuf.emplace_back(std::move(rec));
-            }
-            return;
+    // A track's first step comes after every step of its parent, so the parent's generation is known
+    if (filter.UsesDepth()) {
+        if (track->GetCurrentStepNumber() == 1) {
+            if (trackID >= static_cast<G4int>(depth.size())) depth.resize(trackID + 1, 0);
+            depth[trackID] = parentID > 0 && parentID < trackID ? depth[parentID] + 1 : 0;
         }
+        if (!filter.Depth(depth[trackID])) return;
+    }
+    if (!filter.Volume(volume)) return;
 
-        if (postProc) {
-            const auto& pname = postProc->GetProcessName();
-            if (pname != "Transportation") {
-                InteractionRec rec;
-                rec.trackID = trackID;
-                rec.parentID = parentID;
-                rec.process = pname;
-                rec.volumeName = volName;
-                rec.volumeID = copyNo;
-                rec.pos_mm = x;
-                rec.t_ns = t;
-                rec.secIndex = -1;
-                rec.secPDG = 0;
-                rec.secName = "";
-                rec.secE_MeV = 0.0;
-                rec.secDir = G4ThreeVector();
-                ea->interBuf.emplace_back(std::move(rec));
-            }
+    const auto* postProc = post->GetProcessDefinedStep();
+    if (!hasSecs && (!postProc || postProc->GetProcessType() == fTransportation)) return;
+
+    const G4ThreeVector x = post->GetPosition() / mm;
+    const G4double t = post->GetGlobalTime() / ns;
+    const int copyNo = pv ? pv->GetCopyNo() : -1;
+
+    if (hasSecs) {
+        for (size_t i = 0; i < secs->size(); ++i) {
+            const auto* sc = (*secs)[i];
+            const G4double E = sc->GetKineticEnergy();
+            if (!filter.Energy(E)) continue;
+            const G4int process = codes.Process(sc->GetCreatorProcess());
+            if (!filter.Process(process)) continue;
+            const auto* def = sc->GetDefinition();
+            const G4int particle = codes.Particle(def);
+            if (!filter.Particle(particle)) continue;
+
+            events->interBuf.Add(trackID, parentID, process, volume, copyNo, x, t,
+                                 static_cast<G4int>(i), def->GetPDGEncoding(), particle,
+                                 E / MeV, sc->GetMomentumDirection());
         }
+        return;
     }
+
+    const G4int process = codes.Process(postProc);
+    if (!filter.Process(process) || !filter.Particle(codes.Particle(track->GetDefinition()))) return;
+    events->interBuf.Add(trackID, parentID, process, volume, copyNo, x, t, -1, 0, -1, 0.0, G4ThreeVector());
 }
@@ -0,0 +1,46 @@
+#include "StratifiedSampler.hh"
+
+
+StratifiedSampler::StratifiedSampler(const RunAction *r) : run(r) {
+    nBins = run->GetNBins();
+    if (nBins < 1) {
+        G4Exception("StratifiedSampler::StratifiedSampler", "EnergyRange", FatalException,
+                    "Stratified energy sampling needs a non-empty energy range (E_min < E_max)");
+    }
+    dLog = (run->GetLogEmax() - run->GetLogEmin()) / nBins;
+    weights.assign(nBins, 1.0);
+}
+
+
+void StratifiedSampler::Rebuild() {
+    untilRebuild = std::max(nBins, 100);
+
+    G4double total = 0.0;
+    for (G4int i = 0; i < nBins; ++i) total += run->GetGenerated(i);
+    if (total < warmupPerBin * nBins) {
+        std::fill(weights.begin(), weights.end(), 1.0);
+        table = AliasTable(weights);
+        return;
+    }
+
+    // Bins without a trigger yet (e.g. below threshold) have no usable ratio and live on the floor share
+    G4double sum = 0.0;
+    for (G4int i = 0; i < nBins; ++i) {
+        const G4double gen = run->GetGenerated(i);
+        const G4double trig = run->GetTriggered(i);
+        weights[i] = trig > 0.0 && gen > trig ? std::sqrt((gen - trig) / trig) : 0.0;
+        sum += weights[i];
+    }
+    for (auto &w: weights) {
+        w = sum > 0.0 ? (1.0 - floorShare) * w / sum + floorShare / nBins : 1.0;
+    }
+    table = AliasTable(weights);
+}
+
+
+G4double StratifiedSampler::SampleEnergy() {
+    if (--untilRebuild <= 0) Rebuild();
+
+    const size_t i = table.Sample(G4UniformRand());
+    return std::pow(10.0, run->GetLogEmin() + (static_cast<G4double>(i) + G4UniformRand()) * dLog);
+}